@@ -13,6 +13,7 @@
 #include <odb/pragma.hxx>
 #include <odb/cxx-lexer.hxx>
 #include <odb/diagnostics.hxx>
+#include <odb/stamp.hxx> // hasher
 
 #include <odb/relational/mssql/context.hxx>
 #include <odb/relational/mysql/context.hxx>
@@ -879,7 +880,8 @@ context (ostream& os_,
       multi_dynamic (ops.multi_database () == multi_database::dynamic),
       force_versioned (false),
       top_object (data_->top_object_),
-      cur_object (data_->cur_object_)
+      cur_object (data_->cur_object_),
+      cxx_part (data_->cxx_part_)
 {
   assert (current_ == 0);
   current_ = this;
@@ -992,7 +994,8 @@ context ()
     multi_dynamic (current ().multi_dynamic),
     force_versioned (current ().force_versioned),
     top_object (current ().top_object),
-    cur_object (current ().cur_object)
+    cur_object (current ().cur_object),
+    cxx_part (current ().cxx_part)
 {
 }
 
@@ -1332,6 +1335,24 @@ class_file (semantics::class_& c)
     return c.file ();
 }
 
+bool context::
+in_cxx_part (semantics::class_& c)
+{
+  size_t n (options.cxx_split ());
+
+  if (n < 2)
+    return true;
+
+  // Use the hash of the class name rather than its position in the
+  // file so that adding or removing a class only changes one part. The
+  // hash is fixed-width so that the split does not depend on the host.
+  //
+  hasher h;
+  h.append (class_fq_name (c));
+
+  return h.value () % n == cxx_part;
+}
+
 location_t context::
 class_location (semantics::class_& c)
 {
@@ -3002,6 +3023,19 @@ namespace
   };
 }
 
+// Once the semantic graph is final (the "graph-final" unit annotation is
+// set by the generator), the results of the column_count() and has_a()
+// queries no longer change and we memoize them in the class node. These
+// queries traverse the whole class, including bases, composite values,
+// and containers, and are called many times for each class during code
+// generation.
+//
+namespace
+{
+  typedef map<object_section*, context::column_count_type> column_count_map;
+  typedef map<pair<unsigned short, object_section*>, size_t> has_a_map;
+}
+
 context::column_count_type context::
 column_count (semantics::class_& c, object_section* s)
 {
@@ -3020,8 +3054,25 @@ column_count (semantics::class_& c, object_section* s)
   }
   else
   {
+    column_count_map* m (0);
+
+    if (current ().unit.count ("graph-final"))
+    {
+      m = c.count ("column-count-map")
+        ? &c.get<column_count_map> ("column-count-map")
+        : &c.set ("column-count-map", column_count_map ());
+
+      column_count_map::const_iterator i (m->find (s));
+      if (i != m->end ())
+        return i->second;
+    }
+
     column_count_impl t (s);
     t.traverse (c);
+
+    if (m != 0)
+      (*m)[s] = t.c_;
+
     return t.c_;
   }
 }
@@ -3217,9 +3268,28 @@ is_a (data_member_path const& mp,
 size_t context::
 has_a (semantics::class_& c, unsigned short flags, object_section* s)
 {
+  has_a_map* m (0);
+  has_a_map::key_type k (flags, s);
+
+  if (unit.count ("graph-final"))
+  {
+    m = c.count ("has-a-map")
+      ? &c.get<has_a_map> ("has-a-map")
+      : &c.set ("has-a-map", has_a_map ());
+
+    has_a_map::const_iterator i (m->find (k));
+    if (i != m->end ())
+      return i->second;
+  }
+
   has_a_impl impl (flags, s);
   impl.dispatch (c);
-  return impl.result ();
+  size_t r (impl.result ());
+
+  if (m != 0)
+    (*m)[k] = r;
+
+  return r;
 }
 
 string context::
@@ -25,6 +25,7 @@
 #include <odb/features.hxx>
 #include <odb/location.hxx>
 #include <odb/cxx-token.hxx>
+#include <odb/time-report.hxx>
 #include <odb/semantics.hxx>
 #include <odb/semantics/relational/name.hxx>
 #include <odb/semantics/relational/model.hxx>
@@ -1618,6 +1619,16 @@ public:
     return false;
   }
 
+  // Return true if an ordinary ordered container member should be updated
+  // by comparing its state to the one stored in the database rather than
+  // by re-inserting all the elements (diff_update pragma).
+  //
+  static bool
+  diff_update (semantics::data_member& m)
+  {
+    return m.count ("diff-update");
+  }
+
   // The 'is a' and 'has a' tests. The has_a() test currently does not
   // cross the container boundaries.
   //
@@ -1776,6 +1787,7 @@ protected:
           in_comment_ (false),
           top_object_ (0),
           cur_object_ (0),
+          cxx_part_ (0),
           sql_name_upper_ ("(.+)", "\\U$1"),
           sql_name_lower_ ("(.+)", "\\L$1")
     {
@@ -1792,6 +1804,8 @@ protected:
     semantics::class_* top_object_;
     semantics::class_* cur_object_;
 
+    std::size_t cxx_part_;
+
     string exp_;
     string ext_;
 
@@ -1849,6 +1863,16 @@ public:
   //
   semantics::class_*& cur_object;
 
+  // Part of the C++ source file currently being generated (--cxx-split).
+  //
+  std::size_t& cxx_part;
+
+  // Return true if the source code for the class should be generated
+  // into the current part of the C++ source file.
+  //
+  bool
+  in_cxx_part (semantics::class_&);
+
   // Per-database customizable functionality.
   //
 protected:
@@ -1897,6 +1921,28 @@ private:
   operator= (context const&);
 };
 
+// Add the time from construction to destruction to the time spent
+// generating the class in the time report (--time-report), if any.
+//
+struct class_timer
+{
+  class_timer (semantics::class_& c)
+      : c_ (c), start_ (time_report_ != 0 ? time_now () : time_sample ())
+  {
+  }
+
+  ~class_timer ()
+  {
+    if (time_report_ != 0)
+      time_report_->add_class (context::class_fq_name (c_),
+                               time_now ().wall - start_.wall);
+  }
+
+private:
+  semantics::class_& c_;
+  time_sample start_;
+};
+
 // Create concrete database context.
 //
 std::auto_ptr<context>
@@ -21,6 +21,7 @@ struct features
   bool session_object;
   bool section;
   bool view;
+  bool find_many;
 };
 
 #endif // ODB_FEATURES_HXX
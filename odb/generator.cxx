@@ -22,6 +22,7 @@
 #include <odb/version.hxx>
 #include <odb/context.hxx>
 #include <odb/generator.hxx>
+#include <odb/time-report.hxx>
 
 #include <odb/semantics/relational/model.hxx>
 #include <odb/semantics/relational/changeset.hxx>
@@ -36,7 +37,7 @@ using namespace cutl;
 using semantics::path;
 typedef vector<string> strings;
 typedef vector<path> paths;
-typedef vector<cutl::shared_ptr<ofstream> > ofstreams;
+typedef vector<cutl::shared_ptr<ostringstream> > ostringstreams;
 
 namespace
 {
@@ -76,6 +77,47 @@ namespace
     }
   }
 
+  // Write the generated text to the file unless the file already has
+  // exactly the same content. Leaving such a file untouched preserves its
+  // modification time and saves the build system from recompiling every
+  // translation unit that includes it.
+  //
+  void
+  write (path const& p,
+         string const& text,
+         paths& written,
+         fs::auto_removes& rm,
+         ios_base::openmode m = ios_base::out)
+  {
+    written.push_back (p);
+
+    {
+      ifstream ifs (p.string ().c_str (),
+                    ios_base::in | (m & ios_base::binary));
+
+      if (ifs.is_open ())
+      {
+        ostringstream os;
+
+        if (ifs.peek () != ifstream::traits_type::eof ())
+          os << ifs.rdbuf ();
+
+        if (!ifs.bad () && os.str () == text)
+          return;
+      }
+    }
+
+    ofstream ofs;
+    open (ofs, p, m);
+    rm.add (p);
+
+    if (!(ofs << text) || !ofs.flush ())
+    {
+      cerr << "error: unable to write to '" << p << "'" << endl;
+      throw generator_failed ();
+    }
+  }
+
   void
   append (ostream& os, strings const& text)
   {
@@ -148,16 +190,25 @@ generate (options const& ops,
           features& fts,
           semantics::unit& unit,
           path const& p,
-          paths const& inputs)
+          paths const& inputs,
+          stamp* st)
 {
   namespace sema_rel = semantics::relational;
   using cutl::shared_ptr;
 
   try
   {
+    time_sample ts (time_now ());
+
     database db (ops.database ()[0]);
     multi_database md (ops.multi_database ());
 
+    // The semantic graph does not change from this point on which allows
+    // the context to memoize the results of some of the more expensive
+    // queries (see context::has_a()).
+    //
+    unit.set ("graph-final", true);
+
     // First create the database model.
     //
     bool gen_schema (ops.generate_schema () && db != database::common);
@@ -317,6 +368,8 @@ generate (options const& ops,
         ops);
     }
 
+    end_phase ("model", ts);
+
     // Output files.
     //
     fs::auto_removes auto_rm;
@@ -327,9 +380,21 @@ generate (options const& ops,
     string sch_name (base + ops.schema_file_suffix ()[db] + ops.cxx_suffix ());
     string sql_name (base + ops.sql_file_suffix ()[db] + ops.sql_suffix ());
 
+    // The C++ source file can be split into several parts (--cxx-split)
+    // with the first part written to the normal source file.
+    //
+    strings cxx_names (1, cxx_name);
+
+    for (size_t i (2); i <= ops.cxx_split (); ++i)
+    {
+      ostringstream n;
+      n << base << ops.odb_file_suffix ()[db] << '-' << i << ops.cxx_suffix ();
+      cxx_names.push_back (n.str ());
+    }
+
     path hxx_path (hxx_name);
     path ixx_path (ixx_name);
-    path cxx_path (cxx_name);
+    paths cxx_paths (cxx_names.begin (), cxx_names.end ());
     path sch_path (sch_name);
     path sql_path (sql_name);
     paths mig_pre_paths;
@@ -368,7 +433,10 @@ generate (options const& ops,
       path dir (ops.output_dir ());
       hxx_path = dir / hxx_path;
       ixx_path = dir / ixx_path;
-      cxx_path = dir / cxx_path;
+
+      for (paths::iterator i (cxx_paths.begin ()); i != cxx_paths.end (); ++i)
+        *i = dir / *i;
+
       sch_path = dir / sch_path;
       sql_path = dir / sql_path;
 
@@ -384,31 +452,23 @@ generate (options const& ops,
 
     //
     //
+    // The generated code is first accumulated in memory and only written
+    // to the files once everything has been generated successfully (see
+    // write() above).
+    //
     bool gen_cxx (!ops.generate_schema_only ());
+    bool gen_cxx_source (
+      gen_cxx && (db != database::common || md == multi_database::dynamic));
 
-    ofstream hxx;
-    if (gen_cxx)
-    {
-      open (hxx, hxx_path);
-      auto_rm.add (hxx_path);
-    }
-
-    //
-    //
-    ofstream ixx;
-    if (gen_cxx)
-    {
-      open (ixx, ixx_path);
-      auto_rm.add (ixx_path);
-    }
+    ostringstream hxx;
+    ostringstream ixx;
+    ostringstreams cxx_parts;
 
-    //
-    //
-    ofstream cxx;
-    if (gen_cxx && (db != database::common || md == multi_database::dynamic))
+    if (gen_cxx_source)
     {
-      open (cxx, cxx_path);
-      auto_rm.add (cxx_path);
+      for (size_t i (0); i < cxx_names.size (); ++i)
+        cxx_parts.push_back (
+          shared_ptr<ostringstream> (new (shared) ostringstream));
     }
 
     //
@@ -417,41 +477,25 @@ generate (options const& ops,
       gen_schema &&
       ops.schema_format ()[db].count (schema_format::separate));
 
-    ofstream sch;
-    if (gen_sep_schema)
-    {
-      open (sch, sch_path);
-      auto_rm.add (sch_path);
-    }
+    ostringstream sch;
 
     //
     //
     bool gen_sql_schema (gen_schema &&
                          ops.schema_format ()[db].count (schema_format::sql));
-    ofstream sql;
-    if (gen_sql_schema)
-    {
-      open (sql, sql_path);
-      auto_rm.add (sql_path);
-    }
+    ostringstream sql;
 
     //
     //
-    ofstreams mig_pre, mig_post;
+    ostringstreams mig_pre, mig_post;
     if (gen_sql_migration)
     {
       for (paths::size_type i (0); i < mig_pre_paths.size (); ++i)
       {
-        shared_ptr<ofstream> pre (new (shared) ofstream);
-        shared_ptr<ofstream> post (new (shared) ofstream);
-
-        open (*pre, mig_pre_paths[i]);
-        auto_rm.add (mig_pre_paths[i]);
-        mig_pre.push_back (pre);
-
-        open (*post, mig_post_paths[i]);
-        auto_rm.add (mig_post_paths[i]);
-        mig_post.push_back (post);
+        mig_pre.push_back (
+          shared_ptr<ostringstream> (new (shared) ostringstream));
+        mig_post.push_back (
+          shared_ptr<ostringstream> (new (shared) ostringstream));
       }
     }
 
@@ -463,7 +507,10 @@ generate (options const& ops,
       ixx << cxx_file_header;
 
       if (db != database::common)
-        cxx << cxx_file_header;
+      {
+        for (size_t i (0); i < cxx_parts.size (); ++i)
+          *cxx_parts[i] << cxx_file_header;
+      }
     }
 
     if (gen_sep_schema)
@@ -474,7 +521,7 @@ generate (options const& ops,
 
     if (gen_sql_migration)
     {
-      for (ofstreams::size_type i (0); i < mig_pre.size (); ++i)
+      for (ostringstreams::size_type i (0); i < mig_pre.size (); ++i)
       {
         *mig_pre[i] << sql_file_header;
         *mig_post[i] << sql_file_header;
@@ -602,6 +649,9 @@ generate (options const& ops,
       sloc_total += sloc.stream ().count ();
     }
 
+    if (gen_cxx)
+      end_phase ("generate hxx", ts);
+
     // IXX
     //
     if (gen_cxx)
@@ -662,99 +712,113 @@ generate (options const& ops,
       sloc_total += sloc.stream ().count ();
     }
 
+    if (gen_cxx)
+      end_phase ("generate ixx", ts);
+
     // CXX
     //
-    if (gen_cxx && (db != database::common || md == multi_database::dynamic))
+    if (gen_cxx_source)
     {
-      auto_ptr<context> ctx (
-        create_context (cxx, unit, ops, fts, model.get ()));
+      for (size_t part (0); part < cxx_parts.size (); ++part)
+      {
+        ostringstream& cxx (*cxx_parts[part]);
 
-      sloc_filter sloc (ctx->os);
+        auto_ptr<context> ctx (
+          create_context (cxx, unit, ops, fts, model.get ()));
 
-      // Copy prologue.
-      //
-      append_logue (cxx,
-                    db,
-                    ops.cxx_prologue (),
-                    ops.cxx_prologue_file (),
-                    "// Begin prologue.\n//",
-                    "//\n// End prologue.");
+        ctx->cxx_part = part;
 
-      cxx << "#include <odb/pre.hxx>" << endl
-          << endl;
+        sloc_filter sloc (ctx->os);
 
-      // Include query columns implementations for explicit instantiations.
-      //
-      string impl_guard;
-      if (md == multi_database::dynamic && ctx->ext.empty ())
-      {
-        impl_guard = ctx->make_guard (
-          "ODB_" + db.string () + "_QUERY_COLUMNS_DEF");
-
-        cxx << "#define " << impl_guard << endl;
-      }
+        // Copy prologue.
+        //
+        append_logue (cxx,
+                      db,
+                      ops.cxx_prologue (),
+                      ops.cxx_prologue_file (),
+                      "// Begin prologue.\n//",
+                      "//\n// End prologue.");
 
-      cxx << "#include " << ctx->process_include_path (hxx_name) << endl;
+        cxx << "#include <odb/pre.hxx>" << endl
+            << endl;
 
-      // There are no -odb.hxx includes if we are generating code for
-      // everything.
-      //
-      if (!ops.at_once ())
-        include::generate (false);
+        // Include query columns implementations for explicit instantiations.
+        //
+        string impl_guard;
+        if (md == multi_database::dynamic && ctx->ext.empty ())
+        {
+          impl_guard = ctx->make_guard (
+            "ODB_" + db.string () + "_QUERY_COLUMNS_DEF");
 
-      if (!impl_guard.empty ())
-        cxx << "#undef " << impl_guard << endl;
+          cxx << "#define " << impl_guard << endl;
+        }
 
-      cxx << endl;
+        cxx << "#include " << ctx->process_include_path (hxx_name) << endl;
 
-      {
-        // We don't want to indent prologues/epilogues.
+        // There are no -odb.hxx includes if we are generating code for
+        // everything.
         //
-        ind_filter ind (ctx->os);
+        if (!ops.at_once ())
+          include::generate (false);
+
+        if (!impl_guard.empty ())
+          cxx << "#undef " << impl_guard << endl;
+
+        cxx << endl;
 
-        switch (db)
         {
-        case database::common:
-          {
-            // Dynamic multi-database support.
-            //
-            source::generate ();
-            break;
-          }
-        case database::mssql:
-        case database::mysql:
-        case database::oracle:
-        case database::pgsql:
-        case database::sqlite:
+          // We don't want to indent prologues/epilogues.
+          //
+          ind_filter ind (ctx->os);
+
+          switch (db)
           {
-            relational::source::generate ();
+          case database::common:
+            {
+              // Dynamic multi-database support.
+              //
+              source::generate ();
+              break;
+            }
+          case database::mssql:
+          case database::mysql:
+          case database::oracle:
+          case database::pgsql:
+          case database::sqlite:
+            {
+              relational::source::generate ();
 
-            if (gen_schema &&
-                ops.schema_format ()[db].count (schema_format::embedded))
-              relational::schema::generate_source (changelog.get ());
+              if (gen_schema &&
+                  ops.schema_format ()[db].count (schema_format::embedded) &&
+                  part == 0)
+                relational::schema::generate_source (changelog.get ());
 
-            break;
+              break;
+            }
           }
         }
-      }
 
-      cxx << "#include <odb/post.hxx>" << endl;
+        cxx << "#include <odb/post.hxx>" << endl;
 
-      // Copy epilogue.
-      //
-      append_logue (cxx,
-                    db,
-                    ops.cxx_epilogue (),
-                    ops.cxx_epilogue_file (),
-                    "// Begin epilogue.\n//",
-                    "//\n// End epilogue.");
+        // Copy epilogue.
+        //
+        append_logue (cxx,
+                      db,
+                      ops.cxx_epilogue (),
+                      ops.cxx_epilogue_file (),
+                      "// Begin epilogue.\n//",
+                      "//\n// End epilogue.");
 
-      if (ops.show_sloc ())
-        cerr << cxx_name << ": " << sloc.stream ().count () << endl;
+        if (ops.show_sloc ())
+          cerr << cxx_names[part] << ": " << sloc.stream ().count () << endl;
 
-      sloc_total += sloc.stream ().count ();
+        sloc_total += sloc.stream ().count ();
+      }
     }
 
+    if (gen_cxx_source)
+      end_phase ("generate cxx", ts);
+
     // SCH
     //
     if (gen_sep_schema)
@@ -820,6 +884,9 @@ generate (options const& ops,
       sloc_total += sloc.stream ().count ();
     }
 
+    if (gen_sep_schema)
+      end_phase ("generate schema cxx", ts);
+
     // SQL
     //
     if (gen_sql_schema)
@@ -877,11 +944,14 @@ generate (options const& ops,
       }
     }
 
+    if (gen_sql_schema)
+      end_phase ("generate sql", ts);
+
     // MIG
     //
     if (gen_sql_migration)
     {
-      for (ofstreams::size_type i (0); i < mig_pre.size (); ++i)
+      for (ostringstreams::size_type i (0); i < mig_pre.size (); ++i)
       {
         sema_rel::changeset& cs (
           changelog->contains_changeset_at (i).changeset ());
@@ -889,7 +959,7 @@ generate (options const& ops,
         // pre
         //
         {
-          ofstream& mig (*mig_pre[i]);
+          ostringstream& mig (*mig_pre[i]);
           auto_ptr<context> ctx (create_context (mig, unit, ops, fts, 0));
 
           switch (db)
@@ -932,7 +1002,7 @@ generate (options const& ops,
         // post
         //
         {
-          ofstream& mig (*mig_post[i]);
+          ostringstream& mig (*mig_post[i]);
           auto_ptr<context> ctx (create_context (mig, unit, ops, fts, 0));
 
           switch (db)
@@ -974,6 +1044,40 @@ generate (options const& ops,
       }
     }
 
+    if (gen_sql_migration)
+      end_phase ("generate migration", ts);
+
+    // Write the output files.
+    //
+    paths out_paths;
+
+    if (gen_cxx)
+    {
+      write (hxx_path, hxx.str (), out_paths, auto_rm);
+      write (ixx_path, ixx.str (), out_paths, auto_rm);
+    }
+
+    if (gen_cxx_source)
+    {
+      for (size_t i (0); i < cxx_parts.size (); ++i)
+        write (cxx_paths[i], cxx_parts[i]->str (), out_paths, auto_rm);
+    }
+
+    if (gen_sep_schema)
+      write (sch_path, sch.str (), out_paths, auto_rm);
+
+    if (gen_sql_schema)
+      write (sql_path, sql.str (), out_paths, auto_rm);
+
+    if (gen_sql_migration)
+    {
+      for (ostringstreams::size_type i (0); i < mig_pre.size (); ++i)
+      {
+        write (mig_pre_paths[i], mig_pre[i]->str (), out_paths, auto_rm);
+        write (mig_post_paths[i], mig_post[i]->str (), out_paths, auto_rm);
+      }
+    }
+
     // Save the changelog if it has changed.
     //
     if (gen_changelog)
@@ -1010,6 +1114,24 @@ generate (options const& ops,
       }
     }
 
+    end_phase ("write output", ts);
+
+    // Record the changelog we have read as well as the files we have
+    // generated in the stamp.
+    //
+    if (st != 0)
+    {
+      if (old_changelog != 0)
+        st->deps.push_back (in_log_path);
+
+      if (gen_changelog)
+        out_paths.push_back (out_log_path);
+
+      st->outputs.insert (
+        st->outputs.end (), out_paths.begin (), out_paths.end ());
+      st->sloc += sloc_total;
+    }
+
     // Communicate the sloc count to the driver. This is necessary to
     // correctly handle the total if we are compiling multiple files in
     // one invocation.
@@ -7,17 +7,22 @@
 
 #include <vector>
 
+#include <odb/stamp.hxx>
 #include <odb/options.hxx>
 #include <odb/features.hxx>
 #include <odb/semantics/unit.hxx>
 
 class generator_failed {};
 
+// If the stamp argument is not NULL, then add the files that were
+// generated and read (changelog) as well as the sloc count to it.
+//
 void
 generate (options const&,
           features&,
           semantics::unit&,
           semantics::path const& file,
-          std::vector<semantics::path> const& inputs);
+          std::vector<semantics::path> const& inputs,
+          stamp* = 0);
 
 #endif // ODB_GENERATOR_HXX
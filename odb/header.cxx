@@ -770,6 +770,10 @@ namespace header
     if (ctx.options.std () >= cxx_version::cxx11)
       os << "#include <utility>" << endl; // move()
 
+    if (ctx.features.find_many)
+      os << "#include <map>" << endl
+         << "#include <vector>" << endl; // find (ids)
+
     os << endl;
 
     os << "#include <odb/core.hxx>" << endl
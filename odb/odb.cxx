@@ -15,18 +15,21 @@
 #  include <unistd.h>    // execvp, fork, dup2, pipe, {STDIN,STDERR}_FILENO
 #  include <sys/types.h> // waitpid
 #  include <sys/wait.h>  // waitpid
+#  include <poll.h>      // poll
 #else
 #  ifndef WIN32_LEAN_AND_MEAN
 #    define WIN32_LEAN_AND_MEAN
 #  endif
 #  include <windows.h>   // CreatePipe, CreateProcess
-#  include <io.h>        // _open_osfhandle
+#  include <io.h>        // _open_osfhandle, _read, _close
 #  include <fcntl.h>     // _O_TEXT
 #endif
 
+#include <deque>
 #include <string>
 #include <vector>
 #include <cstddef>     // size_t
+#include <cstdio>      // std::remove
 #include <sstream>
 #include <fstream>
 #include <iostream>
@@ -37,6 +40,8 @@
 #include <odb/version.hxx>
 #include <odb/options.hxx>
 #include <odb/profile.hxx>
+#include <odb/stamp.hxx>
+#include <odb/option-functions.hxx>
 
 #ifdef HAVE_CONFIG_H
 #  include <odb/config.h>
@@ -111,6 +116,51 @@ start_process (char const* args[],
 static bool
 wait_process (process_info, char const* name);
 
+// Read the process' stdout and, if connected, stderr until both are
+// closed. The two streams are drained at the same time so that the
+// process cannot get blocked on a full pipe while we are waiting for the
+// other one to close. The descriptors are closed. Issue diagnostics and
+// return false if anything goes wrong. The name argument is the name of
+// the current process for diagnostics.
+//
+static bool
+read_process (process_info, string& out, string& err, char const* name);
+
+// Plugin processes that have been started and fed their input but whose
+// output hasn't been collected yet. In the parallel mode (--jobs) we keep
+// up to the specified number of such processes running and finish them in
+// the order they were started so that the output is always the same. Any
+// processes still in the queue when it is destroyed (error path) have
+// their pipes closed and are waited for so that we don't leave any
+// zombies behind.
+//
+struct process_queue: deque<process_info>
+{
+  process_queue (char const* n): name (n) {}
+  ~process_queue ();
+
+  char const* name;
+};
+
+// Collect the output of a plugin process started by the driver and wait
+// for it to terminate. Lines in stdout that start with odb:sloc: are
+// added to sloc_total (if count_sloc is true) while everything else is
+// copied to our stdout. If the process' stderr is connected, then its
+// content is copied to our stderr. Return true if the process terminated
+// normally and with the zero exit status. The name argument is the name
+// of the current process for diagnostics.
+//
+static bool
+finish_process (process_info,
+                bool count_sloc,
+                size_t& sloc_total,
+                char const* name);
+
+// Return the number of hardware threads or 1 if it cannot be determined.
+//
+static size_t
+hardware_concurrency ();
+
 //
 //
 static string
@@ -126,6 +176,18 @@ encode_plugin_option (string const& k, string const& v);
 static paths
 profile_paths (strings const& args, char const* name);
 
+// Return true if the ODB compilation prologues and epilogues in x for
+// database xd are the same as in y for database yd.
+//
+static bool
+same_odb_logues (options const& x, database xd, options const& y, database yd);
+
+// Return the stamp file path (--stamp) for the specified input file
+// name and database.
+//
+static path
+stamp_path (options const&, database, string const& name);
+
 static char const* const db_macro[] =
 {
   "-DODB_DATABASE_COMMON",
@@ -548,6 +610,8 @@ main (int argc, char* argv[])
     vector<database> dbs;
     bool show_sloc;
     size_t sloc_limit;
+    size_t jobs;
+    bool single_parse;
     {
       oi[1].search_func = &profile_search_ignore;
       oi[2].search_func = &profile_search_ignore;
@@ -602,6 +666,13 @@ main (int argc, char* argv[])
       show_sloc = ops.show_sloc ();
       sloc_limit = ops.sloc_limit_specified () ? ops.sloc_limit () : 0;
 
+      jobs = ops.jobs () != 0 ? ops.jobs () : hardware_concurrency ();
+
+      // In the single-parse mode we compile each input file once for all
+      // the databases.
+      //
+      single_parse = ops.single_parse () && dbs.size () > 1;
+
       // Translate some ODB options to GCC options.
       //
       switch (ops.std ())
@@ -658,15 +729,20 @@ main (int argc, char* argv[])
     // Compile for each database.
     //
     size_t sloc_total (0);
+    bool count_sloc (show_sloc || sloc_limit != 0);
+    process_queue procs (argv[0]);
 
     for (vector<database>::iterator i (dbs.begin ()); i != dbs.end (); ++i)
     {
       database db (*i);
       strings db_args (args);
 
-      // Add database-specific ODB macro.
+      // Add database-specific ODB macro. In the single-parse mode the
+      // same translation unit is used for all the databases so there
+      // is no such macro.
       //
-      db_args.push_back (db_macro[db]);
+      if (!single_parse)
+        db_args.push_back (db_macro[db]);
 
       // Second parse.
       //
@@ -687,13 +763,46 @@ main (int argc, char* argv[])
         return 1;
       }
 
+      // In the single-parse mode make sure the translation unit that we
+      // synthesize below is the same for all the databases.
+      //
+      if (single_parse)
+      {
+        for (vector<database>::iterator j (dbs.begin () + 1);
+             j != dbs.end (); ++j)
+        {
+          profile_data pd (prof_paths, *j, argv[0]);
+          oi[1].arg = &pd;
+          oi[2].arg = &pd;
+
+          cli::argv_file_scanner scan (ac, &av[0], oi, 3);
+          options jops (scan);
+
+          if (!same_odb_logues (ops, db, jops, *j))
+          {
+            e << argv[0] << ": error: ODB compilation prologues and " <<
+              "epilogues for " << db << " and " << *j << " differ" << endl;
+            e << argv[0] << ": info: --single-parse requires them to be " <<
+              "the same for all the databases" << endl;
+            return 1;
+          }
+        }
+      }
+
       // Encode plugin options.
       //
       // Add the database we are compiling for first. More databases
       // could be specified in options files but they will be ignored
-      // by the plugin (it only cares about the first).
+      // by the plugin (it only cares about the first). In the single-
+      // parse mode add all of them in order.
       //
-      db_args.push_back (encode_plugin_option ("database", db.string ()));
+      if (single_parse)
+      {
+        for (vector<database>::iterator j (dbs.begin ()); j != dbs.end (); ++j)
+          db_args.push_back (encode_plugin_option ("database", j->string ()));
+      }
+      else
+        db_args.push_back (encode_plugin_option ("database", db.string ()));
 
       cli::options const& desc (options::description ());
       for (size_t i (0); i < end; ++i)
@@ -715,6 +824,13 @@ main (int argc, char* argv[])
           i++; // Skip the value.
           continue;
         }
+        else if (a == "--jobs")
+        {
+          // Driver-only option.
+          //
+          i++; // Skip the value.
+          continue;
+        }
 
         cli::options::const_iterator it (desc.find (a));
 
@@ -752,6 +868,17 @@ main (int argc, char* argv[])
       size_t svc_file_pos (db_args.size ());
       db_args.push_back ("");
 
+      // Reserve space for the svc-stamp and svc-hash options if we are
+      // maintaining stamp files.
+      //
+      size_t svc_stamp_pos (0);
+      if (ops.stamp ())
+      {
+        svc_stamp_pos = db_args.size ();
+        db_args.push_back ("");
+        db_args.push_back ("");
+      }
+
       // If compiling multiple input files at once, pass them also with
       // the --svc-file option.
       //
@@ -770,6 +897,20 @@ main (int argc, char* argv[])
             encode_plugin_option ("svc-file", plugin_args[i]));
       }
 
+      // An explicit dependency file would be overwritten by (or, with
+      // --jobs, concurrently written from) each compilation. Writing to
+      // stdout is fine since the output is collected in a fixed order.
+      //
+      if (ops.generate_dep () &&
+          !ops.dep_file ().empty () && ops.dep_file () != "-" &&
+          ((plugin_args.size () - end > 1 && !at_once) ||
+           (dbs.size () > 1 && !single_parse)))
+      {
+        e << argv[0] << ": error: --dep-file cannot be used with multiple " <<
+          "input files or databases unless it is '-'" << endl;
+        return 1;
+      }
+
       // Create an execvp-compatible argument array.
       //
       typedef vector<char const*> cstrings;
@@ -810,23 +951,12 @@ main (int argc, char* argv[])
           }
         }
 
-        if (v)
+        // Synthesize the translation unit. We do it in memory since with
+        // --stamp we need to hash it before deciding whether to compile.
+        //
+        string tu;
         {
-          e << "Compiling " << name << endl;
-          for (cstrings::const_iterator i (exec_args.begin ());
-               i != exec_args.end (); ++i)
-          {
-            if (*i != 0)
-              e << *i << (*(i + 1) != 0 ? ' ' : '\n');
-          }
-        }
-
-        process_info pi (start_process (&exec_args[0], argv[0], false, true));
-
-        {
-          __gnu_cxx::stdio_filebuf<char> fb (
-            pi.out_fd, ios_base::out | ios_base::binary);
-          ostream os (&fb);
+          ostringstream os;
 
           if (!at_once)
           {
@@ -839,8 +969,6 @@ main (int argc, char* argv[])
               if (ifs.get () != 0xBB || ifs.get () != 0xBF)
               {
                 e << name << ": error: invalid UTF-8 BOM sequence" << endl;
-                fb.close ();
-                wait_process (pi, argv[0]);
                 return 1;
               }
 
@@ -923,16 +1051,12 @@ main (int argc, char* argv[])
               if (!ifs.is_open ())
               {
                 e << prof[i] << ": error: unable to open in read mode" << endl;
-                fb.close ();
-                wait_process (pi, argv[0]);
                 return 1;
               }
 
               if (!(os << ifs.rdbuf ()))
               {
                 e << prof[i] << ": error: io failure" << endl;
-                fb.close ();
-                wait_process (pi, argv[0]);
                 return 1;
               }
 
@@ -961,8 +1085,6 @@ main (int argc, char* argv[])
             if (!(os << ifs.rdbuf ()))
             {
               e << name << ": error: io failure" << endl;
-              fb.close ();
-              wait_process (pi, argv[0]);
               return 1;
             }
 
@@ -1000,16 +1122,12 @@ main (int argc, char* argv[])
               if (!ifs.is_open ())
               {
                 e << epif[i] << ": error: unable to open in read mode" << endl;
-                fb.close ();
-                wait_process (pi, argv[0]);
                 return 1;
               }
 
               if (!(os << ifs.rdbuf ()))
               {
                 e << epif[i] << ": error: io failure" << endl;
-                fb.close ();
-                wait_process (pi, argv[0]);
                 return 1;
               }
 
@@ -1048,62 +1166,107 @@ main (int argc, char* argv[])
             //
             os << "#include <odb/container-traits.hxx>" << endl;
           }
+
+          tu = os.str ();
         }
 
-        // Filter the output stream looking for communication from the
-        // plugin.
+        // If requested, check the stamp file and skip the compilation if
+        // neither the input nor any of the included files have changed.
         //
+        if (ops.stamp ())
         {
-          __gnu_cxx::stdio_filebuf<char> fb (pi.in_ofd, ios_base::in);
-          istream is (&fb);
+          path sp (stamp_path (ops, db, name));
 
-          for (bool first (true); !is.eof (); )
-          {
-            string line;
-            getline (is, line);
+          hasher h;
+          h.append (ODB_COMPILER_VERSION_STR);
 
-            if (is.fail () && !is.eof ())
-            {
-              e << argv[0] << ": error: io failure while parsing output"
-                << endl;
-              wait_process (pi, argv[0]);
-              return 1;
-            }
+          for (size_t i (0); i < db_args.size (); ++i)
+          {
+            if (i != svc_stamp_pos && i != svc_stamp_pos + 1)
+              h.append (db_args[i]);
+          }
 
-            if (line.compare (0, 9, "odb:sloc:") == 0)
-            {
-              if (show_sloc || sloc_limit != 0)
-              {
-                size_t n;
-                istringstream is (string (line, 9, string::npos));
+          h.append (tu);
+          string hash (h.string ());
 
-                if (!(is >> n && is.eof ()))
-                {
-                  e << argv[0] << ": error: invalid odb:sloc value" << endl;
-                  wait_process (pi, argv[0]);
-                  return 1;
-                }
+          size_t sloc;
+          if (stamp_up_to_date (sp, hash, sloc))
+          {
+            if (v)
+              e << "Skipping " << name << " (up to date)" << endl;
 
-                sloc_total += n;
-              }
+            sloc_total += sloc;
+            continue;
+          }
 
-              continue;
-            }
+          // Remove the old stamp file in case this compilation fails
+          // after having overwritten some of the generated files.
+          //
+          std::remove (sp.string ().c_str ());
 
-            if (first)
-              first = false;
-            else
-              cout << endl;
+          db_args[svc_stamp_pos] =
+            encode_plugin_option ("svc-stamp", sp.string ());
+          db_args[svc_stamp_pos + 1] = encode_plugin_option ("svc-hash", hash);
+          exec_args[svc_stamp_pos] = db_args[svc_stamp_pos].c_str ();
+          exec_args[svc_stamp_pos + 1] = db_args[svc_stamp_pos + 1].c_str ();
+        }
 
-            cout << line;
+        if (v)
+        {
+          e << "Compiling " << name << endl;
+          for (cstrings::const_iterator i (exec_args.begin ());
+               i != exec_args.end (); ++i)
+          {
+            if (*i != 0)
+              e << *i << (*(i + 1) != 0 ? ' ' : '\n');
           }
         }
 
-        if (!wait_process (pi, argv[0]))
-          return 1;
+        // In the parallel mode also capture stderr so that diagnostics
+        // from different processes don't get interleaved.
+        //
+        process_info pi (
+          start_process (&exec_args[0], argv[0], jobs > 1, true));
+
+        {
+          __gnu_cxx::stdio_filebuf<char> fb (
+            pi.out_fd, ios_base::out | ios_base::binary);
+          ostream os (&fb);
+          os << tu;
+        }
+
+        // Collect the output of the oldest process if we have reached
+        // the maximum number of processes running at the same time.
+        //
+        procs.push_back (pi);
+
+        if (procs.size () >= jobs)
+        {
+          process_info pi (procs.front ());
+          procs.pop_front ();
+
+          if (!finish_process (pi, count_sloc, sloc_total, argv[0]))
+            return 1;
+        }
       } // End input file loop.
+
+      // In the single-parse mode we have compiled for all the databases.
+      //
+      if (single_parse)
+        break;
     } // End database loop.
 
+    // Collect the output of the remaining processes.
+    //
+    while (!procs.empty ())
+    {
+      process_info pi (procs.front ());
+      procs.pop_front ();
+
+      if (!finish_process (pi, count_sloc, sloc_total, argv[0]))
+        return 1;
+    }
+
     // Handle SLOC.
     //
     if (show_sloc)
@@ -1174,6 +1337,142 @@ encode_plugin_option (string const& k, string const& cv)
   return o;
 }
 
+template <typename V>
+static bool
+same_value (database_map<V> const& x, database xd,
+            database_map<V> const& y, database yd)
+{
+  bool xc (x.count (xd) != 0), yc (y.count (yd) != 0);
+  return xc == yc && (!xc || x[xd] == y[yd]);
+}
+
+static bool
+same_odb_logues (options const& x, database xd, options const& y, database yd)
+{
+  return
+    same_value (x.odb_prologue (), xd, y.odb_prologue (), yd) &&
+    same_value (x.odb_prologue_file (), xd, y.odb_prologue_file (), yd) &&
+    same_value (x.odb_epilogue (), xd, y.odb_epilogue (), yd) &&
+    same_value (x.odb_epilogue_file (), xd, y.odb_epilogue_file (), yd);
+}
+
+static path
+stamp_path (options const& o, database db, string const& name)
+{
+  // Get the default generated file suffixes for this database.
+  //
+  options ops (o);
+  ops.database ().insert (ops.database ().begin (), db);
+  process_options (ops);
+
+  path file (ops.input_name ().empty ()
+             ? path (name).leaf ()
+             : path (ops.input_name ()).leaf ());
+
+  path r (file.base ().string () + ops.odb_file_suffix ()[db] + ".stamp");
+
+  if (!ops.output_dir ().empty ())
+    r = path (ops.output_dir ()) / r;
+
+  return r;
+}
+
+static bool
+finish_process (process_info pi,
+                bool count_sloc,
+                size_t& sloc_total,
+                char const* name)
+{
+  // The plugin may write more than just the odb:sloc: line to stdout
+  // (for example, the dependency file with --dep-file -) so we have to
+  // read both streams at the same time.
+  //
+  string out, err;
+  if (!read_process (pi, out, err, name))
+  {
+    wait_process (pi, name);
+    return false;
+  }
+
+  if (!err.empty ())
+    cerr << err << flush;
+
+  // Filter the output stream looking for communication from the
+  // plugin.
+  //
+  {
+    istringstream is (out);
+
+    for (bool first (true); !is.eof (); )
+    {
+      string line;
+      getline (is, line);
+
+      if (is.fail () && !is.eof ())
+      {
+        cerr << name << ": error: io failure while parsing output" << endl;
+        wait_process (pi, name);
+        return false;
+      }
+
+      if (line.compare (0, 9, "odb:sloc:") == 0)
+      {
+        if (count_sloc)
+        {
+          size_t n;
+          istringstream is (string (line, 9, string::npos));
+
+          if (!(is >> n && is.eof ()))
+          {
+            cerr << name << ": error: invalid odb:sloc value" << endl;
+            wait_process (pi, name);
+            return false;
+          }
+
+          sloc_total += n;
+        }
+
+        continue;
+      }
+
+      if (first)
+        first = false;
+      else
+        cout << endl;
+
+      cout << line;
+    }
+  }
+
+  return wait_process (pi, name);
+}
+
+process_queue::
+~process_queue ()
+{
+  for (iterator i (begin ()); i != end (); ++i)
+  {
+    // Closing the pipes will make the process fail writing its output
+    // if it hasn't finished yet.
+    //
+    if (i->in_efd != 0)
+      close (i->in_efd);
+
+    if (i->in_ofd != 0)
+      close (i->in_ofd);
+
+    try
+    {
+      wait_process (*i, name);
+    }
+    catch (process_failure const&)
+    {
+      // Diagnostics has already been issued.
+      //
+    }
+  }
+}
+
 static paths
 profile_paths (strings const& sargs, char const* name)
 {
@@ -1709,6 +2008,84 @@ wait_process (process_info pi, char const* name)
   return WIFEXITED (status) && WEXITSTATUS (status) == 0;
 }
 
+static bool
+read_process (process_info pi, string& out, string& err, char const* name)
+{
+  pollfd fds[2];
+  string* bufs[2];
+  nfds_t n (0);
+
+  fds[n].fd = pi.in_ofd;
+  fds[n].events = POLLIN;
+  bufs[n++] = &out;
+
+  if (pi.in_efd != 0)
+  {
+    fds[n].fd = pi.in_efd;
+    fds[n].events = POLLIN;
+    bufs[n++] = &err;
+  }
+
+  char buf[4096];
+  bool r (true);
+
+  for (nfds_t open (n); open != 0; )
+  {
+    if (poll (fds, n, -1) == -1)
+    {
+      if (errno == EINTR)
+        continue;
+
+      cerr << name << ": error: " << strerror (errno) << endl;
+      r = false;
+      break;
+    }
+
+    for (nfds_t i (0); i != n; ++i)
+    {
+      if (fds[i].fd < 0 || fds[i].revents == 0)
+        continue;
+
+      ssize_t k (read (fds[i].fd, buf, sizeof (buf)));
+
+      if (k == -1)
+      {
+        if (errno == EINTR)
+          continue;
+
+        cerr << name << ": error: " << strerror (errno) << endl;
+        r = false;
+        open = 0;
+        break;
+      }
+
+      if (k == 0)
+      {
+        close (fds[i].fd);
+        fds[i].fd = -1;
+        --open;
+      }
+      else
+        bufs[i]->append (buf, static_cast<size_t> (k));
+    }
+  }
+
+  for (nfds_t i (0); i != n; ++i)
+  {
+    if (fds[i].fd >= 0)
+      close (fds[i].fd);
+  }
+
+  return r;
+}
+
+static size_t
+hardware_concurrency ()
+{
+  long n (sysconf (_SC_NPROCESSORS_ONLN));
+  return n > 0 ? static_cast<size_t> (n) : 1;
+}
+
 #else // _WIN32
 
 static void
@@ -1928,4 +2305,84 @@ wait_process (process_info pi, char const* name)
   return status == 0;
 }
 
+// Read stderr in a separate thread while the calling thread reads stdout.
+//
+struct pipe_reader
+{
+  int fd;
+  string* buf;
+  bool ok;
+};
+
+static bool
+read_pipe (int fd, string& buf)
+{
+  char b[4096];
+
+  for (int k; (k = _read (fd, b, sizeof (b))) != 0; )
+  {
+    if (k == -1)
+      return false;
+
+    buf.append (b, static_cast<size_t> (k));
+  }
+
+  return true;
+}
+
+static DWORD WINAPI
+read_pipe_thread (LPVOID p)
+{
+  pipe_reader& r (*static_cast<pipe_reader*> (p));
+  r.ok = read_pipe (r.fd, *r.buf);
+  return 0;
+}
+
+static bool
+read_process (process_info pi, string& out, string& err, char const* name)
+{
+  pipe_reader er = {pi.in_efd, &err, true};
+  HANDLE t (0);
+
+  if (pi.in_efd != 0)
+  {
+    t = CreateThread (0, 0, &read_pipe_thread, &er, 0, 0);
+
+    if (t == 0)
+    {
+      print_error (name);
+      _close (pi.in_ofd);
+      _close (pi.in_efd);
+      return false;
+    }
+  }
+
+  bool r (read_pipe (pi.in_ofd, out));
+
+  if (t != 0)
+  {
+    WaitForSingleObject (t, INFINITE);
+    CloseHandle (t);
+    _close (pi.in_efd);
+    r = r && er.ok;
+  }
+
+  _close (pi.in_ofd);
+
+  if (!r)
+    cerr << name << ": error: io failure while reading output" << endl;
+
+  return r;
+}
+
+static size_t
+hardware_concurrency ()
+{
+  SYSTEM_INFO si;
+  GetSystemInfo (&si);
+  return si.dwNumberOfProcessors > 0
+    ? static_cast<size_t> (si.dwNumberOfProcessors)
+    : 1;
+}
+
 #endif // _WIN32
@@ -11,11 +11,16 @@
 #include <memory>  // std::auto_ptr
 #include <string>
 #include <vector>
+#include <set>
+#include <algorithm> // std::find
+#include <sstream>
+#include <fstream>
 #include <cstring> // std::strcpy, std::strstr
 #include <cassert>
 #include <iostream>
 
 #include <cutl/re.hxx>
+#include <cutl/shared-ptr.hxx>
 #include <cutl/fs/path.hxx>
 
 #include <odb/pragma.hxx>
@@ -24,7 +29,9 @@
 #include <odb/option-functions.hxx>
 #include <odb/features.hxx>
 #include <odb/profile.hxx>
+#include <odb/stamp.hxx>
 #include <odb/version.hxx>
+#include <odb/time-report.hxx>
 #include <odb/validator.hxx>
 #include <odb/processor.hxx>
 #include <odb/generator.hxx>
@@ -37,12 +44,18 @@ using cutl::fs::path;
 using cutl::fs::invalid_path;
 
 typedef vector<path> paths;
+typedef vector<cutl::shared_ptr<options const> > options_list;
 
 int plugin_is_GPL_compatible;
-auto_ptr<options const> options_;
+options_list options_; // One entry per database (single-parse mode) or
+                       // just the one we are compiling for.
 paths profile_paths_;
 path file_;    // File being compiled.
 paths inputs_; // List of input files in at-once mode or just file_.
+path stamp_path_;   // Stamp file to write or empty if not requested.
+string stamp_hash_; // Compiler input hash to record in the stamp file.
+paths options_files_; // Options files and profiles that were read.
+time_sample start_time_; // Plugin initialization time (--time-report).
 
 bool (*cpp_error_prev) (
   cpp_reader*,
@@ -202,6 +215,161 @@ start_unit_callback (void*, void*)
   }
 }
 
+// Add the files that were included during compilation to the stamp.
+// Synthesized fragments (names in <>) are part of the driver-generated
+// input which is already accounted for by the stamp hash.
+//
+static void
+add_included_files (stamp& st)
+{
+#if BUILDING_GCC_MAJOR >= 6
+  typedef line_map_ordinary line_map_type;
+#else
+  typedef line_map line_map_type;
+#endif
+
+#if BUILDING_GCC_MAJOR == 4 && BUILDING_GCC_MINOR <= 6
+  size_t used (line_table->used);
+  line_map_type const* maps (line_table->maps);
+#else
+  size_t used (line_table->info_ordinary.used);
+  line_map_type const* maps (line_table->info_ordinary.maps);
+#endif
+
+  for (size_t i (0); i < used; ++i)
+  {
+    line_map_type const* m (maps + i);
+
+    if (m->reason != LC_ENTER)
+      continue;
+
+#if BUILDING_GCC_MAJOR == 4 && BUILDING_GCC_MINOR <= 6
+    char const* f (m->to_file);
+#else
+    char const* f (ORDINARY_MAP_FILE_NAME (m));
+#endif
+
+    if (f != 0 && *f != '\0' && *f != '<')
+      st.deps.push_back (path (f));
+  }
+}
+
+// Escape special characters in a make rule target or prerequisite.
+//
+static string
+make_escape (string const& s)
+{
+  string r;
+
+  for (size_t i (0); i < s.size (); ++i)
+  {
+    char c (s[i]);
+
+    if (c == ' ' || c == '\t' || c == '#' || c == '\\')
+      r += '\\';
+    else if (c == '$')
+      r += '$';
+
+    r += c;
+  }
+
+  return r;
+}
+
+// Write the make dependency file (--generate-dep). Return false if
+// unable to write the file.
+//
+static bool
+write_dep_file (path const& dp, stamp const& st)
+{
+  options const& ops (*options_[0]);
+
+  // Targets.
+  //
+  strings ts;
+
+  if (ops.dep_target_specified ())
+    ts = ops.dep_target ();
+  else
+  {
+    for (paths::const_iterator i (st.outputs.begin ());
+         i != st.outputs.end (); ++i)
+      ts.push_back (i->string ());
+  }
+
+  // Prerequisites: the input file(s), the stamp dependencies (included
+  // headers, options files, and changelog), and the prologue/epilogue
+  // files.
+  //
+  paths ps (inputs_);
+  ps.insert (ps.end (), st.deps.begin (), st.deps.end ());
+
+  for (options_list::const_iterator i (options_.begin ());
+       i != options_.end (); ++i)
+  {
+    options const& o (**i);
+    database db (o.database ()[0]);
+
+    if (o.odb_prologue_file ().count (db) != 0)
+    {
+      strings const& pf (o.odb_prologue_file ()[db]);
+      for (strings::const_iterator j (pf.begin ()); j != pf.end (); ++j)
+        ps.push_back (path (*j));
+    }
+
+    if (o.odb_epilogue_file ().count (db) != 0)
+    {
+      strings const& ef (o.odb_epilogue_file ()[db]);
+      for (strings::const_iterator j (ef.begin ()); j != ef.end (); ++j)
+        ps.push_back (path (*j));
+    }
+  }
+
+  ostringstream os;
+
+  for (strings::const_iterator i (ts.begin ()); i != ts.end (); ++i)
+    os << (i != ts.begin () ? " " : "") << make_escape (*i);
+
+  os << ":";
+
+  set<path> seen;
+  strings ups; // Unique prerequisites.
+
+  for (paths::const_iterator i (ps.begin ()); i != ps.end (); ++i)
+  {
+    if (seen.insert (*i).second)
+    {
+      ups.push_back (make_escape (i->string ()));
+      os << " \\" << endl
+         << "  " << ups.back ();
+    }
+  }
+
+  os << endl;
+
+  if (ops.dep_phony ())
+  {
+    for (strings::const_iterator i (ups.begin ()); i != ups.end (); ++i)
+      os << endl
+         << *i << ":" << endl;
+  }
+
+  if (dp.string () == "-")
+  {
+    cout << os.str () << flush;
+    return true;
+  }
+
+  ofstream ofs (dp.string ().c_str (), ios_base::out);
+
+  if (!ofs.is_open ())
+    return false;
+
+  ofs << os.str ();
+  ofs.close ();
+  return !ofs.fail ();
+}
+
 extern "C" void
 gate_callback (void*, void*)
 {
@@ -213,38 +381,137 @@ gate_callback (void*, void*)
 
   int r (0);
 
+  // Everything up to this point was spent by GCC parsing the translation
+  // unit.
+  //
+  time_sample ts (start_time_);
+  end_phase ("C++ parsing", ts);
+
   try
   {
-    // Post process pragmas.
+    // The stamp is also used to collect the dependency information.
     //
-    post_process_pragmas ();
+    stamp st;
+    st.hash = stamp_hash_;
+    bool collect (!stamp_path_.empty () || options_[0]->generate_dep ());
 
-    // Parse the GCC tree to semantic graph.
-    //
-    parser p (*options_, loc_pragmas_, ns_loc_pragmas_, decl_pragmas_);
-    auto_ptr<unit> u (p.parse (global_namespace, file_));
+    for (options_list::const_iterator i (options_.begin ());
+         i != options_.end (); ++i)
+    {
+      options const& ops (**i);
+      database db (ops.database ()[0]);
 
-    features f;
+      // In the single-parse mode each database has its own set of
+      // pragmas.
+      //
+      bool swap (options_.size () > 1);
 
-    // Process, pass 1.
-    //
-    process (*options_, f, *u, file_, 1);
+      if (swap)
+        swap_pragmas (db);
 
-    // Validate, pass 1.
-    //
-    validate (*options_, f, *u, file_, 1);
+      pragma_db_ = db;
+
+      if (time_report_ != 0 && swap)
+        time_report_->prefix = db.string () + ": ";
+
+      // Post process pragmas.
+      //
+      post_process_pragmas ();
+      end_phase ("pragmas", ts);
+
+      // Parse the GCC tree to semantic graph. Note that we re-create the
+      // semantic graph for each database since it is annotated with the
+      // database-specific information during processing.
+      //
+      parser p (ops, loc_pragmas_, ns_loc_pragmas_, decl_pragmas_);
+      auto_ptr<unit> u (p.parse (global_namespace, file_));
+      end_phase ("semantic graph", ts);
+
+      features f;
+
+      // Process, pass 1.
+      //
+      process (ops, f, *u, file_, 1);
+      end_phase ("process 1", ts);
+
+      // Validate, pass 1.
+      //
+      validate (ops, f, *u, file_, 1);
+      end_phase ("validate 1", ts);
+
+      // Process, pass 2.
+      //
+      process (ops, f, *u, file_, 2);
+      end_phase ("process 2", ts);
+
+      // Validate, pass 2.
+      //
+      validate (ops, f, *u, file_, 2);
+      end_phase ("validate 2", ts);
+
+      // Generate.
+      //
+      generate (ops, f, *u, file_, inputs_, collect ? &st : 0);
+      ts = time_now (); // Generator records its own phases.
 
-    // Process, pass 2.
+      if (swap)
+        swap_pragmas (db);
+    }
+
+    // Note that the options files and profiles are passed to us by the
+    // driver unexpanded so they are not covered by the stamp hash.
     //
-    process (*options_, f, *u, file_, 2);
+    if (collect)
+    {
+      add_included_files (st);
+      st.deps.insert (
+        st.deps.end (), options_files_.begin (), options_files_.end ());
+    }
 
-    // Validate, pass 2.
+    // Write the dependency file. Note that the stamp file records it as
+    // one of the outputs so that it is recreated if removed.
     //
-    validate (*options_, f, *u, file_, 2);
+    if (options_[0]->generate_dep ())
+    {
+      options const& ops (*options_[0]);
+      database db (ops.database ()[0]);
+      path dp;
+
+      if (!ops.dep_file ().empty ())
+        dp = path (ops.dep_file ());
+      else
+      {
+        path file (ops.input_name ().empty ()
+                   ? file_.leaf ()
+                   : path (ops.input_name ()).leaf ());
+
+        dp = path (file.base ().string () +
+                   ops.odb_file_suffix ()[db] +
+                   ops.dep_suffix ());
+
+        if (!ops.output_dir ().empty ())
+          dp = path (ops.output_dir ()) / dp;
+      }
+
+      if (!write_dep_file (dp, st))
+      {
+        cerr << "error: unable to write dependency file '" << dp << "'" <<
+          endl;
+        r = 1;
+      }
+      else if (dp.string () != "-")
+        st.outputs.push_back (dp);
+    }
 
-    // Generate.
+    // Write the stamp file now that everything has been successfully
+    // generated.
     //
-    generate (*options_, f, *u, file_, inputs_);
+    if (r == 0 && !stamp_path_.empty () && !save_stamp (stamp_path_, st))
+    {
+      cerr << "error: unable to write stamp file '" << stamp_path_ <<
+        "'" << endl;
+      r = 1;
+    }
   }
   catch (cutl::re::format const& e)
   {
@@ -283,6 +550,13 @@ gate_callback (void*, void*)
     r = 1;
   }
 
+  if (time_report_ != 0)
+  {
+    time_report_->prefix.clear ();
+    end_phase ("finalization", ts);
+    time_report_->print (cerr, 10);
+  }
+
   exit (r);
 }
 
@@ -324,6 +598,18 @@ plugin_init (plugin_name_args* plugin_info, plugin_gcc_version*)
           continue;
         }
 
+        if (strcmp (a.key, "svc-stamp") == 0)
+        {
+          stamp_path_ = path (v);
+          continue;
+        }
+
+        if (strcmp (a.key, "svc-hash") == 0)
+        {
+          stamp_hash_ = v;
+          continue;
+        }
+
         if (strcmp (a.key, "svc-file") == 0)
         {
           // First is the main file. Subsequent are inputs in the at-once
@@ -363,7 +649,7 @@ plugin_init (plugin_name_args* plugin_info, plugin_gcc_version*)
       oi[1].option = "-p";
       oi[2].option = "--profile";
 
-      database db;
+      vector<database> dbs;
       {
         oi[1].search_func = &profile_search_ignore;
         oi[2].search_func = &profile_search_ignore;
@@ -371,29 +657,77 @@ plugin_init (plugin_name_args* plugin_info, plugin_gcc_version*)
         cli::argv_file_scanner scan (argc, &argv[0], oi, 3);
         options ops (scan);
         assert (ops.database_specified ());
-        db = ops.database ()[0];
+
+        // In the single-parse mode we generate code for all the databases
+        // specified. Otherwise we only care about the first.
+        //
+        vector<database> const& v (ops.database ());
+
+        for (vector<database>::const_iterator i (v.begin ()); i != v.end ();
+             ++i)
+        {
+          if (find (dbs.begin (), dbs.end (), *i) == dbs.end ())
+            dbs.push_back (*i);
+
+          if (!ops.single_parse ())
+            break;
+        }
       }
 
-      profile_data pd (profile_paths_, db, "odb plugin");
-      oi[1].search_func = &profile_search;
-      oi[2].search_func = &profile_search;
-      oi[1].arg = &pd;
-      oi[2].arg = &pd;
+      for (vector<database>::const_iterator i (dbs.begin ()); i != dbs.end ();
+           ++i)
+      {
+        database db (*i);
 
-      cli::argv_file_scanner scan (argc, &argv[0], oi, 3);
-      auto_ptr<options> ops (
-        new options (scan, cli::unknown_mode::fail, cli::unknown_mode::fail));
+        profile_data pd (profile_paths_, db, "odb plugin");
+        oi[0].search_func = &options_file_search;
+        oi[1].search_func = &profile_search;
+        oi[2].search_func = &profile_search;
+        oi[0].arg = &pd;
+        oi[1].arg = &pd;
+        oi[2].arg = &pd;
 
-      // Process options.
-      //
-      process_options (*ops);
+        cli::argv_file_scanner scan (argc, &argv[0], oi, 3);
+        auto_ptr<options> ops (
+          new options (scan, cli::unknown_mode::fail, cli::unknown_mode::fail));
 
-      options_ = ops;
-      pragma_db_ = db;
-      pragma_multi_ = options_->multi_database ();
+        // Make the database we are generating code for the first.
+        //
+        if (i != dbs.begin ())
+          ops->database ().insert (ops->database ().begin (), db);
+
+        // Process options.
+        //
+        process_options (*ops);
+
+        options_.push_back (cutl::shared_ptr<options const> (ops.release ()));
+
+        // Remember the options files and profiles that we have read
+        // (--stamp, --generate-dep).
+        //
+        options_files_.insert (options_files_.end (),
+                               pd.options_files.begin (),
+                               pd.options_files.end ());
+        options_files_.insert (options_files_.end (),
+                               pd.loaded.begin (),
+                               pd.loaded.end ());
+      }
+
+      pragma_db_ = dbs[0];
+      pragma_multi_ = options_[0]->multi_database ();
+
+      if (dbs.size () > 1)
+        pragma_dbs_ = dbs;
+    }
+
+    if (options_[0]->time_report ())
+    {
+      static time_report tr;
+      time_report_ = &tr;
+      start_time_ = time_now ();
     }
 
-    if (options_->trace ())
+    if (options_[0]->trace ())
       cerr << "starting plugin " << plugin_info->base_name << endl;
 
     // Disable assembly output. GCC doesn't define HOST_BIT_BUCKET
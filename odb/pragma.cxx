@@ -30,6 +30,32 @@ ns_loc_pragmas ns_loc_pragmas_;
 
 database pragma_db_;
 multi_database pragma_multi_;
+vector<database> pragma_dbs_;
+
+namespace
+{
+  struct pragma_tables
+  {
+    virt_declarations virt;
+    loc_pragmas loc;
+    decl_pragmas decl;
+    ns_loc_pragmas ns_loc;
+  };
+
+  typedef map<database, pragma_tables> db_pragma_tables;
+  db_pragma_tables db_pragmas_;
+}
+
+void
+swap_pragmas (database db)
+{
+  pragma_tables& t (db_pragmas_[db]);
+
+  virt_declarations_.swap (t.virt);
+  loc_pragmas_.swap (t.loc);
+  decl_pragmas_.swap (t.decl);
+  ns_loc_pragmas_.swap (t.ns_loc);
+}
 
 template <typename X>
 void
@@ -512,7 +538,8 @@ check_spec_decl_type (declaration const& d,
            p == "polymorphic" ||
            p == "definition" ||
            p == "sectionable" ||
-           p == "bulk")
+           p == "bulk" ||
+           p == "find_many")
   {
     if (tc != RECORD_TYPE)
     {
@@ -651,6 +678,17 @@ check_spec_decl_type (declaration const& d,
       return false;
     }
   }
+  else if (p == "diff_update")
+  {
+    // Diff_update can be used for data members only.
+    //
+    if (tc != FIELD_DECL)
+    {
+      error (l) << "name '" << name << "' in db pragma " << p << " does "
+                << "not refer to a data member" << endl;
+      return false;
+    }
+  }
   else if (p == "virtual")
   {
     // Virtual is specified for a member.
@@ -1594,6 +1632,18 @@ handle_pragma (cxx_lexer& l,
 
     tt = l.next (tl, &tn);
   }
+  else if (p == "find_many")
+  {
+    // find_many
+    //
+
+    // Make sure we've got the correct declaration type.
+    //
+    if (decl && !check_spec_decl_type (decl, decl_name, p, loc))
+      return;
+
+    tt = l.next (tl, &tn);
+  }
   else if (p == "callback")
   {
     // callback (name)
@@ -2701,6 +2751,18 @@ handle_pragma (cxx_lexer& l,
 
     tt = l.next (tl, &tn);
   }
+  else if (p == "diff_update")
+  {
+    // diff_update
+    //
+
+    // Make sure we've got the correct declaration type.
+    //
+    if (decl && !check_spec_decl_type (decl, decl_name, p, loc))
+      return;
+
+    tt = l.next (tl, &tn);
+  }
   else if (p == "readonly")
   {
     // readonly
@@ -3846,6 +3908,7 @@ handle_pragma_qualifier (cxx_lexer& l, string p)
            p == "on_delete" ||
            p == "points_to" ||
            p == "unordered" ||
+           p == "diff_update" ||
            p == "readonly" ||
            p == "transient" ||
            p == "added" ||
@@ -4244,6 +4307,12 @@ handle_pragma_db_unordered (cpp_reader* r)
   handle_pragma_qualifier (r, "unordered");
 }
 
+extern "C" void
+handle_pragma_db_diff_update (cpp_reader* r)
+{
+  handle_pragma_qualifier (r, "diff_update");
+}
+
 extern "C" void
 handle_pragma_db_readonly (cpp_reader* r)
 {
@@ -4281,12 +4350,9 @@ handle_pragma_db_virtual (cpp_reader* r)
 }
 */
 
-extern "C" void
-handle_pragma_db (cpp_reader*)
+static void
+handle_db_pragma (cxx_lexer& l)
 {
-  cxx_pragma_lexer l;
-  l.start ();
-
   string tl;
   cpp_ttype tt (l.next (tl));
 
@@ -4299,6 +4365,59 @@ handle_pragma_db (cpp_reader*)
   handle_pragma_qualifier (l, tl);
 }
 
+extern "C" void
+handle_pragma_db (cpp_reader*)
+{
+  cxx_pragma_lexer l;
+  l.start ();
+
+  if (pragma_dbs_.size () < 2)
+  {
+    handle_db_pragma (l);
+    return;
+  }
+
+  // Single-parse mode. We can only lex the pragma once so save its
+  // tokens and then handle it for each database as if it was the
+  // one we are compiling for.
+  //
+  cxx_tokens ts;
+  {
+    string tl;
+    tree tn;
+
+    for (cpp_ttype tt (l.next (tl, &tn));
+         tt != CPP_EOF;
+         tt = l.next (tl, &tn))
+      ts.push_back (cxx_token (l.location (), tt, tl, tn));
+  }
+
+  database db (pragma_db_);
+
+  for (vector<database>::const_iterator i (pragma_dbs_.begin ());
+       i != pragma_dbs_.end (); ++i)
+  {
+    int ec (errorcount);
+
+    swap_pragmas (*i);
+    pragma_db_ = *i;
+
+    cxx_tokens_lexer tl;
+    tl.start (ts, l.location ());
+    handle_db_pragma (tl);
+
+    swap_pragmas (*i);
+
+    // Most of the errors are database-independent so don't issue the
+    // same diagnostics for every database.
+    //
+    if (errorcount != ec)
+      break;
+  }
+
+  pragma_db_ = db;
+}
+
 extern "C" void
 register_odb_pragmas (void*, void*)
 {
@@ -4357,6 +4476,7 @@ register_odb_pragmas (void*, void*)
   c_register_pragma_with_expansion ("db", "on_delete", handle_pragma_db_on_delete);
   c_register_pragma_with_expansion ("db", "points_to", handle_pragma_db_points_to);
   c_register_pragma_with_expansion ("db", "unordered", handle_pragma_db_unordered);
+  c_register_pragma_with_expansion ("db", "diff_update", handle_pragma_db_diff_update);
   c_register_pragma_with_expansion ("db", "readonly", handle_pragma_db_readonly);
   c_register_pragma_with_expansion ("db", "transient", handle_pragma_db_transient);
   c_register_pragma_with_expansion ("db", "added", handle_pragma_db_added);
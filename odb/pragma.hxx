@@ -277,6 +277,20 @@ extern decl_pragmas decl_pragmas_;
 extern database pragma_db_;
 extern multi_database pragma_multi_;
 
+// Databases we are generating code for in the single-parse mode. If there
+// is more than one, then each pragma is handled once for every database
+// with the virtual declaration and pragma tables above replaced with the
+// ones for this database (see swap_pragmas() below).
+//
+extern std::vector<database> pragma_dbs_;
+
+// Swap the virtual declaration and pragma tables above with the ones
+// saved for the specified database. Calling this function again with
+// the same database swaps them back.
+//
+void
+swap_pragmas (database);
+
 extern "C" void
 register_odb_pragmas (void*, void*);
 
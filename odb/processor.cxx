@@ -1737,6 +1737,33 @@ namespace
         throw operation_failed ();
       }
 
+      // Diff-based update only makes sense for a non-inverse ordered
+      // container. Smart containers track their changes themselves so
+      // for them the pragma is redundant.
+      //
+      if (m.count ("diff-update"))
+      {
+        if (ck != ck_ordered || unordered (m) || m.count ("value-inverse"))
+        {
+          error (ml) << "diff_update can only be specified for a " <<
+            "non-inverse ordered container" << endl;
+          throw operation_failed ();
+        }
+
+        // Comparing freshly loaded object pointers would be both expensive
+        // and meaningless.
+        //
+        if (object_pointer (*vt))
+        {
+          error (ml) << "diff_update cannot be specified for a container " <<
+            "of object pointers" << endl;
+          throw operation_failed ();
+        }
+
+        if (smart)
+          m.remove ("diff-update");
+      }
+
       // Issue a warning if we are relaxing null-ness in the member.
       //
       if (m.count ("value-null") &&
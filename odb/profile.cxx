@@ -85,3 +85,14 @@ profile_search_ignore (char const*, void*)
 {
   return string ();
 }
+
+string
+options_file_search (char const* file, void* arg)
+{
+  profile_data* pd (static_cast<profile_data*> (arg));
+
+  if (*file != '\0')
+    pd->options_files.push_back (profile_data::path (file));
+
+  return file;
+}
@@ -27,6 +27,7 @@ struct profile_data
   database db;
   char const* name;
   std::set<path> loaded;
+  paths options_files; // Files read via --options-file.
 };
 
 struct profile_failure {};
@@ -37,4 +38,10 @@ profile_search (char const* profile, void* arg);
 std::string
 profile_search_ignore (char const* profile, void* arg);
 
+// Search function for the --options-file option that records the file in
+// profile_data::options_files and returns it unchanged.
+//
+std::string
+options_file_search (char const* file, void* arg);
+
 #endif // ODB_PROFILE_HXX
@@ -515,6 +515,13 @@ traverse_object (type& c)
          << "find (database&, const id_type&);"
          << endl;
 
+    // find (ids)
+    //
+    if (c.count ("find-many"))
+      os << "static std::size_t" << endl
+         << "find (database&, const id_type*, std::size_t, pointer_type*);"
+         << endl;
+
     // find (id, obj)
     //
     os << "static bool" << endl
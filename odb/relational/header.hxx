@@ -316,9 +316,13 @@ namespace relational
           }
         }
 
+        // A diff-updated container uses the smart container statements
+        // and functions.
+        //
+        bool diff (diff_update (m));
         bool smart (!inverse &&
                     (ck != ck_ordered || ordered) &&
-                    container_smart (c));
+                    (container_smart (c) || diff));
 
         string name (flat_prefix_ + public_name (m) + "_traits");
 
@@ -980,7 +984,7 @@ namespace relational
           os << "static void" << endl
              << "erase (";
 
-          if (smart)
+          if (smart && !diff)
             os << "const container_type*, ";
 
           os << "statements_type&);"
@@ -1279,6 +1283,8 @@ namespace relational
 
         names (c);
 
+        class_timer t (c);
+
         switch (ck)
         {
         case class_object: traverse_object (c); break;
@@ -1369,6 +1375,8 @@ namespace relational
 
         names (c);
 
+        class_timer t (c);
+
         switch (ck)
         {
         case class_object: traverse_object (c); break;
@@ -113,7 +113,7 @@ namespace relational
             return;
 
           bool smart (!inverse (m, "value") && !unordered (m) &&
-                      container_smart (t));
+                      (container_smart (t) || diff_update (m)));
 
           // Container statement names.
           //
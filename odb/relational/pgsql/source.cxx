@@ -876,7 +876,8 @@ namespace relational
           data_member_path* imp (inverse (m, "value"));
           bool inv (imp != 0);
 
-          bool smart (!inv && !unordered (m) && container_smart (t));
+          bool smart (!inv && !unordered (m) &&
+                      (container_smart (t) || diff_update (m)));
 
           // Statment names.
           //
@@ -1453,6 +1453,7 @@ traverse_object (type& c)
        << "conn.statement_cache ().find_object<object_type> ());";
 
     if (versioned ||
+        persist_versioned_containers ||
         uss.count (user_sections::count_new |
                    user_sections::count_all |
                    user_sections::count_versioned_only) != 0)
@@ -1582,6 +1583,32 @@ traverse_object (type& c)
          << endl;
     }
 
+    // The container statements cannot be executed while the results of
+    // the batch are still being read (for example, SQL Server fetches
+    // them lazily and the connection is busy until then). So we make
+    // the container calls for the successful positions (those without
+    // an exception in mex) in a separate loop.
+    //
+    if (persist_containers)
+    {
+      os << "}"  // for
+         << "for (std::size_t i (0); i != n; ++i)"
+         << "{"
+         << "if (mex.fatal ())" << endl
+         << "break;"
+         << endl
+         << "if (mex[i] != 0)" << endl
+         << "continue;"
+         << endl
+         << (auto_id ? "" : "const ") << "object_type& obj (*objs[i]);"
+         << endl;
+
+      bulk_containers (
+        c, container_calls::persist_call, 0, "id (obj)", opt != 0,
+        "continue;");
+      os << endl;
+    }
+
     os << "callback (db," << endl
        << (auto_id ? "static_cast<const object_type&> (obj)," : "obj,") << endl
        << "callback_event::post_persist);"
@@ -2189,6 +2216,16 @@ traverse_object (type& c)
   //
   if (id != 0 && !readonly && c.count ("bulk-update"))
   {
+    size_t update_containers (
+      has_a (c, test_readwrite_container, &main_section));
+
+    bool update_versioned_containers (
+      update_containers >
+      has_a (c,
+             test_readwrite_container |
+             exclude_deleted | exclude_added | exclude_versioned,
+             &main_section));
+
     os << "void " << traits << "::" << endl
        << "update (database& db," << endl
        << "const object_type** objs," << endl
@@ -2205,7 +2242,7 @@ traverse_object (type& c)
        << "statements_type& sts (" << endl
        << "conn.statement_cache ().find_object<object_type> ());";
 
-    if (versioned)
+    if (versioned || update_versioned_containers)
       os << "const schema_version_migration& svm (" <<
         "sts.version_migration (" << schema_name << "));";
 
@@ -2299,6 +2336,32 @@ traverse_object (type& c)
       os << endl;
     }
 
+    // Make the container calls after all the results have been read (see
+    // persist() bulk above).
+    //
+    if (update_containers)
+    {
+      os << "}"  // for
+         << "for (std::size_t i (0); i != n; ++i)"
+         << "{"
+         << "if (mex.fatal ())" << endl
+         << "break;"
+         << endl
+         << "if (mex[i] != 0)" << endl
+         << "continue;"
+         << endl
+         << "const object_type& obj (*objs[i]);"
+         << endl;
+
+      bulk_containers (c,
+                       container_calls::update_call,
+                       &main_section,
+                       "id (obj)",
+                       opt != 0,
+                       "continue;");
+      os << endl;
+    }
+
     os << "callback (db, obj, callback_event::post_update);"
        << "pointer_cache_traits::update (db, obj);"
        << "}"  // for
@@ -2440,7 +2503,13 @@ traverse_object (type& c)
 
   // erase (id) bulk
   //
-  if (id != 0 && c.count ("bulk-erase"))
+  // If we have containers, then erase one element at a time so that the
+  // container and object rows of each element are erased together (see
+  // below).
+  //
+  bool bulk_erase_each (erase_containers != 0);
+
+  if (id != 0 && c.count ("bulk-erase") && !bulk_erase_each)
   {
     os << "std::size_t " << traits << "::" << endl
        << "erase (database& db," << endl
@@ -2793,7 +2862,7 @@ traverse_object (type& c)
 
   // erase (object) bulk
   //
-  if (id != 0 && c.count ("bulk-erase"))
+  if (id != 0 && c.count ("bulk-erase") && !bulk_erase_each)
   {
     os << "void " << traits << "::" << endl
        << "erase (database& db," << endl
@@ -2884,6 +2953,38 @@ traverse_object (type& c)
     os << "}"; // erase()
   }
 
+  // erase () bulk for objects with containers. Here we simply execute
+  // the single-object erase() for each element, recording the "expected"
+  // exceptions for the position and stopping at the first unexpected
+  // (fatal) one.
+  //
+  if (id != 0 && c.count ("bulk-erase") && bulk_erase_each)
+  {
+    os << "std::size_t " << traits << "::" << endl
+       << "erase (database& db," << endl
+       << "const id_type** ids," << endl
+       << "std::size_t n," << endl
+       << "multiple_exceptions& mex)"
+       << "{";
+
+    bulk_loop ("erase (db, *ids[i])", "object_not_persistent", true);
+
+    os << "return n;"
+       << "}";
+
+    os << "void " << traits << "::" << endl
+       << "erase (database& db," << endl
+       << "const object_type** objs," << endl
+       << "std::size_t n," << endl
+       << "multiple_exceptions& mex)"
+       << "{";
+
+    bulk_loop ("erase (db, *objs[i])",
+               opt == 0 ? "object_not_persistent" : "object_changed");
+
+    os << "}";
+  }
+
   // find (id)
   //
   if (id != 0 && c.default_ctor ())
@@ -3065,6 +3166,68 @@ traverse_object (type& c)
        << "}";
   }
 
+  // find (ids)
+  //
+  // Load the objects with the query() IN condition on the id column in
+  // chunks that are small enough not to exceed the statement parameter
+  // limits of any of the databases (e.g., 1000 IN list elements in Oracle
+  // and 999 parameters in older SQLite versions). Each distinct id is
+  // loaded once and the object is stored at the first position with
+  // this id. Positions with duplicate ids are left NULL so that the same
+  // object is never returned (and, with raw pointers, owned) twice. A row
+  // whose id does not match any of the requested ids exactly is skipped
+  // without loading the object.
+  //
+  if (c.count ("find-many"))
+  {
+    string qc ("odb::query_columns< " + class_fq_name (c) + ", id_" +
+               db.string () + ", " + traits + " >::" + public_name (*idf));
+
+    os << "std::size_t " << traits << "::" << endl
+       << "find (database& db," << endl
+       << "const id_type* ids," << endl
+       << "std::size_t n," << endl
+       << "pointer_type* objs)"
+       << "{"
+       << "typedef std::map<id_type, std::size_t> position_map;"
+       << endl
+       << "position_map pm;"
+       << "std::vector<id_type> u;"
+       << "u.reserve (n);"
+       << endl
+       << "for (std::size_t i (0); i != n; ++i)"
+       << "{"
+       << "objs[i] = pointer_type ();"
+       << endl
+       << "if (pm.insert (position_map::value_type (ids[i], i)).second)" << endl
+       << "u.push_back (ids[i]);"
+       << "}"
+       << "const std::size_t chunk (500);"
+       << "std::size_t r (0);"
+       << endl
+       << "for (std::size_t b (0), m (u.size ()); b < m; b += chunk)"
+       << "{"
+       << "std::size_t e (m - b < chunk ? m : b + chunk);"
+       << endl
+       << "result<object_type> q (" << endl
+       << "query (db, " << qc << ".in_range (&u[0] + b, &u[0] + e)));"
+       << endl
+       << "for (result<object_type>::iterator j (q.begin ()); " <<
+      "j != q.end (); ++j)"
+       << "{"
+       << "position_map::const_iterator k (pm.find (j.id ()));"
+       << endl
+       << "if (k == pm.end ())" << endl
+       << "continue;"
+       << endl
+       << "objs[k->second] = j.load ();"
+       << "r++;"
+       << "}"  // for
+       << "}"  // for
+       << "return r;"
+       << "}";
+  }
+
   // find (id, obj)
   //
   if (id != 0)
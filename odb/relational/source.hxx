@@ -3522,9 +3522,13 @@ namespace relational
           }
         }
 
+        // A diff-updated container uses the smart container statements
+        // and functions but drives them itself.
+        //
+        bool diff (diff_update (m));
         bool smart (!inverse &&
                     (ck != ck_ordered || ordered) &&
-                    container_smart (t));
+                    (container_smart (t) || diff));
 
         if (generate_grow)
           grow = grow || context::grow (m, vt, vct, "value");
@@ -4827,17 +4831,28 @@ namespace relational
           os << ")"
              << "{"
              << "using namespace " << db << ";"
-             << endl
-             << "functions_type& fs (sts.functions ());";
+             << endl;
+
+          if (!diff)
+            os << "functions_type& fs (sts.functions ());";
 
           if (versioned)
             os << "sts.version_migration (svm);";
 
-          if (!smart && ck == ck_ordered)
-            os << "fs.ordered_ = " << ordered << ";";
+          if (diff)
+            os << "index_type i (0);"
+               << "for (container_type::const_iterator j (c.begin ()), "
+               << "e (c.end ()); j != e; ++j, ++i)" << endl
+               << "insert (i, *j, &sts);"
+               << "}";
+          else
+          {
+            if (!smart && ck == ck_ordered)
+              os << "fs.ordered_ = " << ordered << ";";
 
-          os << "container_traits_type::persist (c, fs);"
-             << "}";
+            os << "container_traits_type::persist (c, fs);"
+               << "}";
+          }
         }
 
         // load
@@ -4897,17 +4912,31 @@ namespace relational
              << "}";
 
         os << "bool more (r != select_statement::no_data);"
-           << endl
-           << "functions_type& fs (sts.functions ());";
+           << endl;
+
+        if (!diff)
+          os << "functions_type& fs (sts.functions ());";
 
         if (versioned)
           os << "sts.version_migration (svm);";
 
-        if (!smart && ck == ck_ordered)
-          os << "fs.ordered_ = " << ordered << ";";
+        if (diff)
+          os << "c.clear ();"
+             << "while (more)"
+             << "{"
+             << "index_type i;"
+             << "c.push_back (value_type ());"
+             << "more = select (i, c.back (), &sts);"
+             << "}"
+             << "}";
+        else
+        {
+          if (!smart && ck == ck_ordered)
+            os << "fs.ordered_ = " << ordered << ";";
 
-        os << "container_traits_type::load (c, more, fs);"
-           << "}";
+          os << "container_traits_type::load (c, more, fs);"
+             << "}";
+        }
 
         // update
         //
@@ -4924,17 +4953,47 @@ namespace relational
           os << ")"
              << "{"
              << "using namespace " << db << ";"
-             << endl
-             << "functions_type& fs (sts.functions ());";
+             << endl;
 
-          if (versioned)
-            os << "sts.version_migration (svm);";
+          if (diff)
+          {
+            // Load the state stored in the database and only send the
+            // differences: update the changed elements in the common
+            // prefix and then either delete the tail or insert the new
+            // elements.
+            //
+            os << "container_type o;"
+               << "load (o, sts" << (versioned ? ", svm" : "") << ");"
+               << endl
+               << "index_type i (0);"
+               << "container_type::const_iterator j (c.begin ()), je (c.end ());"
+               << "container_type::const_iterator k (o.begin ()), ke (o.end ());"
+               << endl
+               << "for (; j != je && k != ke; ++j, ++k, ++i)"
+               << "{"
+               << "if (!(*j == *k))" << endl
+               << "update (i, *j, &sts);"
+               << "}"
+               << "if (k != ke)" << endl
+               << "delete_ (i, &sts);"
+               << endl
+               << "for (; j != je; ++j, ++i)" << endl
+               << "insert (i, *j, &sts);"
+               << "}";
+          }
+          else
+          {
+            os << "functions_type& fs (sts.functions ());";
 
-          if (!smart && ck == ck_ordered)
-            os << "fs.ordered_ = " << ordered << ";";
+            if (versioned)
+              os << "sts.version_migration (svm);";
 
-          os << "container_traits_type::update (c, fs);"
-             << "}";
+            if (!smart && ck == ck_ordered)
+              os << "fs.ordered_ = " << ordered << ";";
+
+            os << "container_traits_type::update (c, fs);"
+               << "}";
+          }
         }
 
         // erase
@@ -4944,20 +5003,28 @@ namespace relational
           os << "void " << scope << "::" << endl
              << "erase (";
 
-          if (smart)
+          if (smart && !diff)
             os << "const container_type* c, ";
 
           os << "statements_type& sts)"
              << "{"
              << "using namespace " << db << ";"
-             << endl
-             << "functions_type& fs (sts.functions ());";
+             << endl;
 
-          if (!smart && ck == ck_ordered)
-            os << "fs.ordered_ = " << ordered << ";";
+          if (diff)
+            os << "delete_ (0, &sts);"
+               << "}";
+          else
+          {
+            os << "functions_type& fs (sts.functions ());";
 
-          os << "container_traits_type::erase (" << (smart ? "c, " : "") << "fs);"
-             << "}";
+            if (!smart && ck == ck_ordered)
+              os << "fs.ordered_ = " << ordered << ";";
+
+            os << "container_traits_type::erase (" << (smart ? "c, " : "") <<
+              "fs);"
+               << "}";
+          }
         }
       }
 
@@ -4982,7 +5049,7 @@ namespace relational
       {
         bool smart (!context::inverse (m, "value") &&
                     !unordered (m) &&
-                    container_smart (c));
+                    (container_smart (c) || diff_update (m)));
 
         string traits (flat_prefix_ + public_name (m) + "_traits");
 
@@ -6648,11 +6715,13 @@ namespace relational
         class_kind_type ck (class_kind (c));
 
         if (ck == class_other ||
-            (!options.at_once () && class_file (c) != unit.file ()))
+            (!options.at_once () && class_file (c) != unit.file ()) ||
+            !in_cxx_part (c))
           return;
 
         names (c);
 
+        class_timer t (c);
         context::top_object = context::cur_object = &c;
 
         switch (ck)
@@ -6758,6 +6827,71 @@ namespace relational
         return false;
       }
 
+      // Emit the loop of a bulk operation that makes the specified
+      // single-object call for each element. If count is true, then
+      // the function returns the number of elements attempted.
+      //
+      void
+      bulk_loop (string const& call, string const& expected, bool count = false)
+      {
+        os << "for (std::size_t i (0); i != n; ++i)"
+           << "{"
+           << "try"
+           << "{"
+           << call << ";"
+           << "}"
+           << "catch (const " << expected << "& e)"
+           << "{"
+           << "mex.insert (i, e);"
+           << "}"
+           << "catch (const odb::exception& e)"
+           << "{"
+           << "mex.insert (i, e, true);"
+           << "return" << (count ? " i + 1" : "") << ";"
+           << "}"
+           << "}";
+      }
+
+      // Emit the container calls for the current element of a bulk
+      // operation. Since the batch id images are in use, we go through
+      // the first one and record any exception as fatal for the position.
+      //
+      void
+      bulk_containers (type& c,
+                       container_calls::call_type call,
+                       object_section* section,
+                       string const& id,
+                       bool optimistic,
+                       string const& fail)
+      {
+        os << "try"
+           << "{"
+           << "id_image_type& idi (sts.id_image ());"
+           << "init (idi, " << id << ");"
+           << endl
+           << "binding& ib (sts.id_image_binding ());"
+           << "if (idi.version != sts.id_image_version () || ib.version == 0)"
+           << "{"
+           << "bind (ib.bind, idi);"
+           << "sts.id_image_version (idi.version);"
+           << "ib.version++;";
+        if (optimistic)
+          os << "sts.optimistic_id_image_binding ().version++;";
+        os << "}"
+           << "extra_statement_cache_type& esc (sts.extra_statement_cache ());"
+           << endl;
+
+        instance<container_calls> t (call, section);
+        t->traverse (c);
+
+        os << "}"
+           << "catch (const odb::exception& e)"
+           << "{"
+           << "mex.insert (i, e, true);"
+           << fail
+           << "}";
+      }
+
       virtual void
       traverse_object (type& c);
 
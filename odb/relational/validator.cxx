@@ -397,14 +397,6 @@ namespace relational
             break;
           }
 
-          if (has_a (c, test_straight_container))
-          {
-            error (l) << "bulk operations on objects with containers are "
-              "not supported" << endl;
-            valid_ = false;
-            break;
-          }
-
           bool update (true);
 
           // Unless we only have manually-updated sections, we cannot generate
@@ -435,6 +427,75 @@ namespace relational
           c.set ("bulk-erase", true);
         }
 
+        // Validate multi-id find() support. It is implemented in terms of
+        // query() with the IN condition on the id column so we need query
+        // support, a simple (not composite or wrapped) id, and the default
+        // ctor. The loaded objects are matched to positions with std::map
+        // so we also limit the id to integer and enum types which compare
+        // the same way in C++ and SQL (unlike, for example, characters with
+        // case-insensitive collations or floating-point values after a
+        // precision round trip).
+        //
+        for (bool i (true); i && c.count ("find-many"); i = false)
+        {
+          location_t l (c.get<location_t> ("find-many-location"));
+
+          if (!options.generate_query () || options.omit_unprepared ())
+          {
+            error (l) << "multi-id find() requires unprepared query "
+              "support" << endl;
+            info (l) << "use the --generate-query option without "
+              "--omit-unprepared to enable it" << endl;
+            valid_ = false;
+            break;
+          }
+
+          if (id == 0 || id->size () != 1)
+          {
+            error (l) << "multi-id find() is only supported for objects "
+              "with simple ids" << endl;
+            valid_ = false;
+            break;
+          }
+
+          if (abstract (c) && !polymorphic (c))
+          {
+            error (l) << "multi-id find() is not supported for reuse-"
+              "abstract objects" << endl;
+            valid_ = false;
+            break;
+          }
+
+          if (!c.default_ctor ())
+          {
+            error (l) << "multi-id find() requires a default constructor"
+                      << endl;
+            valid_ = false;
+            break;
+          }
+
+          semantics::type& t (utype (*id));
+
+          bool ok (dynamic_cast<semantics::enum_*> (&t) != 0 ||
+                   (dynamic_cast<semantics::integral_type*> (&t) != 0 &&
+                    dynamic_cast<semantics::fund_char*> (&t) == 0 &&
+                    dynamic_cast<semantics::fund_signed_char*> (&t) == 0 &&
+                    dynamic_cast<semantics::fund_unsigned_char*> (&t) == 0 &&
+                    dynamic_cast<semantics::fund_wchar*> (&t) == 0 &&
+                    dynamic_cast<semantics::fund_char16*> (&t) == 0 &&
+                    dynamic_cast<semantics::fund_char32*> (&t) == 0));
+
+          if (!ok)
+          {
+            error (l) << "multi-id find() is only supported for objects "
+              "with integer or enum ids" << endl;
+            valid_ = false;
+            break;
+          }
+
+          features.find_many = true;
+        }
+
         // Validate indexes.
         //
         {
@@ -28,7 +28,8 @@ namespace source
       class_kind_type ck (class_kind (c));
 
       if (ck == class_other ||
-          (!options.at_once () && class_file (c) != unit.file ()))
+          (!options.at_once () && class_file (c) != unit.file ()) ||
+          !in_cxx_part (c))
         return;
 
       names (c);
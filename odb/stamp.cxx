@@ -0,0 +1,176 @@
+// file      : odb/stamp.cxx
+// copyright : Copyright (c) 2009-2017 Code Synthesis Tools CC
+// license   : GNU GPL v3; see accompanying LICENSE file
+
+#include <sys/types.h> // stat
+#include <sys/stat.h>  // stat
+
+#include <set>
+#include <cstdio>  // std::remove
+#include <sstream>
+#include <fstream>
+
+#include <odb/stamp.hxx>
+
+using namespace std;
+
+typedef stamp::path path;
+typedef stamp::paths paths;
+
+void hasher::
+append (char const* s, size_t n)
+{
+  for (size_t i (0); i < n; ++i)
+  {
+    h_ ^= static_cast<unsigned char> (s[i]);
+    h_ *= 0x100000001b3ULL;
+  }
+}
+
+string hasher::
+string () const
+{
+  ostringstream os;
+  os << hex;
+  os.width (16);
+  os.fill ('0');
+  os << h_;
+  return os.str ();
+}
+
+static bool
+exist (path const& p)
+{
+  struct stat info;
+  return stat (p.string ().c_str (), &info) == 0;
+}
+
+// Calculate the hash of the file's content. Return false if the file
+// cannot be read.
+//
+static bool
+hash_file (path const& p, string& r)
+{
+  ifstream ifs (p.string ().c_str (), ios_base::in | ios_base::binary);
+
+  if (!ifs.is_open ())
+    return false;
+
+  hasher h;
+  char buf[4096];
+
+  do
+  {
+    ifs.read (buf, sizeof (buf));
+    h.append (buf, static_cast<size_t> (ifs.gcount ()));
+  } while (ifs.good ());
+
+  if (ifs.bad ())
+    return false;
+
+  r = h.string ();
+  return true;
+}
+
+// Stamp file format (one record per line):
+//
+// odb-stamp 1
+// hash <hash>
+// sloc <count>
+// dep <hash> <path>
+// out <path>
+//
+bool
+stamp_up_to_date (path const& p, string const& hash, size_t& sloc)
+{
+  ifstream ifs (p.string ().c_str (), ios_base::in);
+
+  if (!ifs.is_open ())
+    return false;
+
+  string l;
+
+  if (!getline (ifs, l) || l != "odb-stamp 1")
+    return false;
+
+  if (!getline (ifs, l) || l.compare (0, 5, "hash ") != 0 ||
+      l.compare (5, string::npos, hash) != 0)
+    return false;
+
+  if (!getline (ifs, l) || l.compare (0, 5, "sloc ") != 0)
+    return false;
+
+  {
+    istringstream is (string (l, 5, string::npos));
+    if (!(is >> sloc && is.eof ()))
+      return false;
+  }
+
+  while (getline (ifs, l))
+  {
+    if (l.compare (0, 4, "dep ") == 0)
+    {
+      string::size_type n (l.find (' ', 4));
+
+      if (n == string::npos)
+        return false;
+
+      string h;
+      if (!hash_file (path (string (l, n + 1, string::npos)), h) ||
+          l.compare (4, n - 4, h) != 0)
+        return false;
+    }
+    else if (l.compare (0, 4, "out ") == 0)
+    {
+      if (!exist (path (string (l, 4, string::npos))))
+        return false;
+    }
+    else
+      return false;
+  }
+
+  return !ifs.bad ();
+}
+
+bool
+save_stamp (path const& p, stamp const& s)
+{
+  ostringstream os;
+
+  os << "odb-stamp 1" << endl
+     << "hash " << s.hash << endl
+     << "sloc " << s.sloc << endl;
+
+  set<path> seen;
+  for (paths::const_iterator i (s.deps.begin ()); i != s.deps.end (); ++i)
+  {
+    if (!seen.insert (*i).second)
+      continue;
+
+    string h;
+    if (!hash_file (*i, h))
+      return false;
+
+    os << "dep " << h << " " << i->string () << endl;
+  }
+
+  for (paths::const_iterator i (s.outputs.begin ());
+       i != s.outputs.end (); ++i)
+    os << "out " << i->string () << endl;
+
+  ofstream ofs (p.string ().c_str (), ios_base::out);
+
+  if (!ofs.is_open ())
+    return false;
+
+  ofs << os.str ();
+  ofs.close ();
+
+  if (ofs.fail ())
+  {
+    std::remove (p.string ().c_str ());
+    return false;
+  }
+
+  return true;
+}
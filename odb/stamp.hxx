@@ -0,0 +1,84 @@
+// file      : odb/stamp.hxx
+// copyright : Copyright (c) 2009-2017 Code Synthesis Tools CC
+// license   : GNU GPL v3; see accompanying LICENSE file
+
+#ifndef ODB_STAMP_HXX
+#define ODB_STAMP_HXX
+
+#include <string>
+#include <vector>
+#include <cstddef> // std::size_t
+
+#include <cutl/fs/path.hxx>
+
+// Stamp file support (--stamp). The driver hashes the synthesized
+// translation unit together with the compiler options and, if the
+// stamp file for this compilation records the same hash, all the
+// included files are unchanged, and all the generated files exist,
+// skips the compilation altogether. Otherwise the plugin writes the
+// new stamp file once the code has been successfully generated.
+//
+
+// 64-bit FNV-1a hash.
+//
+class hasher
+{
+public:
+  hasher (): h_ (0xcbf29ce484222325ULL) {}
+
+  void
+  append (char const*, std::size_t);
+
+  void
+  append (std::string const& s)
+  {
+    // Include the terminating '\0' so that, for example, ("ab", "c")
+    // and ("a", "bc") hash differently.
+    //
+    append (s.c_str (), s.size () + 1);
+  }
+
+  unsigned long long
+  value () const
+  {
+    return h_;
+  }
+
+  // Return the hash as a hex string.
+  //
+  std::string
+  string () const;
+
+private:
+  unsigned long long h_;
+};
+
+struct stamp
+{
+  typedef cutl::fs::path path;
+  typedef std::vector<path> paths;
+
+  stamp (): sloc (0) {}
+
+  std::string hash;  // Hash of the compiler input and options.
+  std::size_t sloc;  // Total number of generated lines.
+  paths deps;        // Files that were read during compilation.
+  paths outputs;     // Files that were generated.
+};
+
+// Return true if the stamp file exists, records the specified hash,
+// all its dependencies have the same content as recorded, and all the
+// generated files exist. In this case also return the recorded sloc
+// count.
+//
+bool
+stamp_up_to_date (stamp::path const&, std::string const& hash, std::size_t& sloc);
+
+// Write the stamp file calculating the hashes of the dependencies. Return
+// false if unable to read a dependency or write the stamp file in which
+// case the partially written stamp file is removed.
+//
+bool
+save_stamp (stamp::path const&, stamp const&);
+
+#endif // ODB_STAMP_HXX
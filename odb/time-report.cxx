@@ -0,0 +1,142 @@
+// file      : odb/time-report.cxx
+// copyright : Copyright (c) 2009-2017 Code Synthesis Tools CC
+// license   : GNU GPL v3; see accompanying LICENSE file
+
+#include <sys/time.h>       // gettimeofday
+#ifndef _WIN32
+#  include <sys/resource.h> // getrusage
+#endif
+
+#include <ctime>   // std::clock
+#include <utility> // std::pair
+#include <iomanip>
+#include <ostream>
+#include <algorithm>
+
+#include <odb/time-report.hxx>
+
+using namespace std;
+
+time_report* time_report_;
+
+time_sample
+time_now ()
+{
+  time_sample r;
+
+  timeval tv;
+  if (gettimeofday (&tv, 0) == 0)
+    r.wall = tv.tv_sec + tv.tv_usec / 1000000.0;
+
+  r.cpu = static_cast<double> (clock ()) / CLOCKS_PER_SEC;
+  return r;
+}
+
+size_t
+peak_rss ()
+{
+#ifndef _WIN32
+  rusage ru;
+  if (getrusage (RUSAGE_SELF, &ru) == 0)
+  {
+#ifdef __APPLE__
+    return static_cast<size_t> (ru.ru_maxrss) / 1024; // Bytes.
+#else
+    return static_cast<size_t> (ru.ru_maxrss); // Kilobytes.
+#endif
+  }
+#endif
+  return 0;
+}
+
+void
+end_phase (char const* name, time_sample& ts)
+{
+  if (time_report_ != 0)
+  {
+    time_report_->add_phase (name, ts);
+    ts = time_now ();
+  }
+}
+
+void time_report::
+add_phase (string const& name, time_sample const& start)
+{
+  time_sample now (time_now ());
+
+  phase p;
+  p.name = prefix + name;
+  p.time.wall = now.wall - start.wall;
+  p.time.cpu = now.cpu - start.cpu;
+  p.rss = peak_rss ();
+  phases_.push_back (p);
+}
+
+void time_report::
+add_class (string const& name, double wall)
+{
+  classes_[name] += wall;
+}
+
+namespace
+{
+  struct greater_time
+  {
+    bool
+    operator() (pair<double, string> const& x,
+                pair<double, string> const& y) const
+    {
+      return x.first > y.first;
+    }
+  };
+}
+
+void time_report::
+print (ostream& os, size_t classes) const
+{
+  ios_base::fmtflags f (os.flags ());
+  os << fixed << setprecision (3);
+
+  os << "time report:" << endl
+     << "  " << left << setw (28) << "phase" << right
+     << setw (10) << "wall" << setw (10) << "cpu"
+     << setw (14) << "peak rss" << endl;
+
+  time_sample total;
+  for (vector<phase>::const_iterator i (phases_.begin ());
+       i != phases_.end (); ++i)
+  {
+    os << "  " << left << setw (28) << i->name << right
+       << setw (9) << i->time.wall << 's'
+       << setw (9) << i->time.cpu << 's'
+       << setw (11) << i->rss << " KB" << endl;
+
+    total.wall += i->time.wall;
+    total.cpu += i->time.cpu;
+  }
+
+  os << "  " << left << setw (28) << "total" << right
+     << setw (9) << total.wall << 's'
+     << setw (9) << total.cpu << 's'
+     << setw (11) << peak_rss () << " KB" << endl;
+
+  if (classes != 0 && !classes_.empty ())
+  {
+    vector<pair<double, string> > cs;
+    for (map<string, double>::const_iterator i (classes_.begin ());
+         i != classes_.end (); ++i)
+      cs.push_back (make_pair (i->second, i->first));
+
+    stable_sort (cs.begin (), cs.end (), greater_time ());
+
+    if (cs.size () > classes)
+      cs.resize (classes);
+
+    os << "most expensive classes to generate:" << endl;
+
+    for (size_t i (0); i < cs.size (); ++i)
+      os << "  " << setw (9) << cs[i].first << "s  " << cs[i].second << endl;
+  }
+
+  os.flags (f);
+}
@@ -0,0 +1,77 @@
+// file      : odb/time-report.hxx
+// copyright : Copyright (c) 2009-2017 Code Synthesis Tools CC
+// license   : GNU GPL v3; see accompanying LICENSE file
+
+#ifndef ODB_TIME_REPORT_HXX
+#define ODB_TIME_REPORT_HXX
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstddef> // std::size_t
+#include <iosfwd>
+
+// Wall clock and CPU time in seconds.
+//
+struct time_sample
+{
+  time_sample (): wall (0), cpu (0) {}
+
+  double wall;
+  double cpu;
+};
+
+time_sample
+time_now ();
+
+// Return the peak resident set size of this process in kilobytes or 0
+// if it cannot be determined.
+//
+std::size_t
+peak_rss ();
+
+// Compilation time report (--time-report).
+//
+class time_report
+{
+public:
+  // Record the phase that started at the specified time and ended now.
+  // The name is prefixed with the current prefix (used to distinguish
+  // databases in the single-parse mode).
+  //
+  void
+  add_phase (std::string const& name, time_sample const& start);
+
+  // Add the wall clock time to the total spent generating the class.
+  //
+  void
+  add_class (std::string const& name, double wall);
+
+  void
+  print (std::ostream&, std::size_t classes) const;
+
+  std::string prefix;
+
+private:
+  struct phase
+  {
+    std::string name;
+    time_sample time;
+    std::size_t rss;
+  };
+
+  std::vector<phase> phases_;
+  std::map<std::string, double> classes_;
+};
+
+// Report for the current compilation or NULL if not requested.
+//
+extern time_report* time_report_;
+
+// Record the phase that started at ts in the time report, if any, and
+// reset ts to the current time.
+//
+void
+end_phase (char const* name, time_sample& ts);
+
+#endif // ODB_TIME_REPORT_HXX